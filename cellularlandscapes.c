@@ -5,45 +5,183 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <linux/input-event-codes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 #include <sys/random.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <linux/perf_event.h>
 #include <time.h>
 #include <unistd.h>
 #include <wayland-client-protocol.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include "xdg-shell-protocol.h"
 
 #define fail_wl_init        "couldn't init all necessary wayland components.\n"
 #define fail_landscape_init "couldn't init the desired landscape.\n"
 
-#define STEP_TIME_MSEC 150
+// How the simulation is paced: a fixed number of generations a second, off a
+// timer; a number of generations for each frame the compositor shows, off the
+// frame callbacks; or flat out.
+enum pace { pace_rate, pace_frame, pace_free };
+#define STEP_RATE 8 // [generations/s] to start with
+#define LEAP_MAX 20 // KEY_F's 2^leap, but for hashlife, whose time isn't linear
+
+#define RULES_MAX 16
+#define STATES_MAX 16 // a Generations rule's, see life_lut
+#define RULE_TILE 64 // [cells], a packed word
+
+// Larger than Life [Evans, "Larger than Life: digital creatures in a family of
+// two-dimensional cellular automata", DMTCS 2001] counts the living within
+// `range` of a cell, over a square (Moore) or a diamond (von Neumann), and is
+// born or survives when the count falls in a band. The rest is as for
+// Generations: `states` of them, the dying age out. `middle` counts the cell
+// itself. Golly writes it `Rr,Cc,Mm,Smin..max,Bmin..max,Nn`, C0 for two.
+#define LTL_RANGE_MAX 100
+enum ltl_shape { ltl_moore, ltl_neumann };
+struct ltl {
+	uint32_t range, states, middle;
+	uint32_t smin, smax, bmin, bmax;
+	enum ltl_shape shape;
+};
 
 struct landscape {
 	// geometry
 	size_t width, height; // [cells]
-	void (*quotient)(struct landscape *landscape,
-			int x, int y, size_t *X, size_t *Y);
+	size_t stride;        // [cells per row, halo included]
+	void (*quotient)(struct landscape *landscape, uint8_t *grid,
+			size_t y0, size_t y1);
 
 	// dynamics
 	uint32_t rule;
-	void (*automata)(struct landscape *, int, int, uint32_t);
-
-	// flip and flop hold the state of the landscape
+	void (*automata)(struct landscape *, const uint8_t *from, uint8_t *to,
+			size_t y, uint32_t rule);
+	struct ltl ltl; // the rule when automata is twod_larger
+
+	// Stochastic stepping (see noise_fill): each cell steps with chance
+	// alpha/256 and otherwise stays as it was, 256 being deterministic. A
+	// 1D rule can instead give each of its eight patterns a chance of a
+	// live cell, odds[p]/256, in place of the rule's bit p.
+	uint32_t alpha;
+	uint16_t odds[8];
+	uint32_t odds_on:1;
+	uint64_t key;        // the generator's; -S, or from getrandom
+	uint64_t generation; // stepped since the start
+
+	// The most states of any rule in play when the cells were last stepped;
+	// 2 unless a Generations rule is (see life_lut).
+	uint32_t states;
+
+	// Painted rules: each RULE_TILE square of cells steps by the life-like
+	// rule its byte of `rules` picks from the palette, 0 being `rule`.
+	// NULL until something's painted. `ink` is what the brush paints.
+	uint8_t *rules;
+	size_t rules_w; // [tiles per row]
+	uint32_t palette[RULES_MAX];
+	uint32_t ink;
+	const struct engine *engine;
+	size_t threads;
+
+	// flip and flop hold the state of the landscape. Each is row-major
+	// with a one cell halo all round; the quotient refills the halo as rows
+	// are finished so the automata never have to look past it.
 	uint8_t *show, *flip, *flop;
 
+	// The packed engine keeps 64 cells per word, each row padded out to
+	// `words` words. Whichever of show and the engine's copy was written
+	// last is the truth; the stale bits say which needs a refresh.
+	uint64_t *packed, *packed_next;
+	size_t words; // [words per row]
+	// Under a Generations rule `packed` holds the living, and the dying
+	// keep their age, state - 1, bit-sliced over states_planes(states)
+	// more planes of packed rows.
+	uint64_t *dying, *dying_next;
+	uint32_t show_stale:1,
+		engine_stale:1;
+
 	// aesthetics
 	size_t cell_width, cell_height, cell_wall;
+
+	// batch runs: step `generations` without a display, then write the
+	// result to `output`
+	size_t generations;
+	const char *output;
+	uint64_t seed;
+
+	// -x's life-like rules to sweep instead, see landscape_sweep
+	const char *sweep;
+
+	// the mapped engine's file
+	const char *store;
+
+	// an RLE or .cells file to start from
+	const char *pattern;
+
+	// -r's rules to paint, each "x,y,w,h,Bx/Sy"
+	const char **regions;
+	size_t nregions;
 };
 
+// An engine owns a representation of the landscape's state and knows how to
+// advance it. `show` is always the byte view used for drawing and painting;
+// engines with their own storage convert to and from it lazily.
+struct engine {
+	const char *name;
+	int  (*init)(struct landscape *);
+	void (*advance)(struct landscape *, size_t gens);
+	void (*pack)(struct landscape *);   // show -> engine
+	void (*unpack)(struct landscape *); // engine -> show
+};
+
+// What the window shows: vw x vh units of cw x ch pixels, unit (i, j)
+// standing for the 2^block x 2^block cells from (x0 + i<<block,
+// y0 + j<<block). Zoomed in, a unit is one cell drawn big; zoomed out far
+// enough, a block of cells drawn by how full it is.
+struct view {
+	int64_t x0, y0; // [cells], multiples of 2^block
+	int32_t zoom;   // 0 is the cell size asked for
+	uint32_t block;
+	uint32_t cw, ch; // [px]
+	uint32_t vw, vh; // [units]
+	uint32_t pw, ph; // [px], the window
+};
+
+#define WINDOW_MAX_W 1920
+#define WINDOW_MAX_H 1080
+
 struct buffer {
 	struct wl_buffer *wl_buffer;
 	uint32_t *pixels;
+	// What each unit looked like when this buffer was last drawn, and the
+	// view's geometry then. Buffers can be held by the compositor for any
+	// number of frames, so each keeps its own and is brought up to date
+	// from there.
+	uint8_t *cells;
+	struct view view;
+	size_t offset; // [bytes] into the pool
+	uint32_t width, height; // [px]
 	uint8_t busy:1;
 };
 
+#define BUFFERS_MAX 3
+
+struct rect {
+	int32_t x, y, w, h;
+};
+
+#define DAMAGE_MAX 64
+
 // The first crack kept everything local and nice. But I'm in a global kind of
 // mood. And this way the wl stays singleton (not that it really matters.)
 struct {
@@ -59,10 +197,33 @@ struct {
 	struct wl_keyboard   *keyboard;
 	struct wl_callback   *frame_cb;
 
-	struct buffer buffers[2];
-
-	int32_t pointer_cell;
+	// Two buffers until the compositor holds on to both, then a third.
+	struct buffer buffers[BUFFERS_MAX];
+	size_t nbuffers;
+	struct buffer *front; // last attached
+	uint8_t *look; // a row of cells as drawn, cursor and all
+	size_t look_w;
+	int32_t config_w, config_h; // [px] asked for by the compositor, 0 if not
+	int32_t want_w, want_h; // [px] last passed on to the simulation
+
+	// what changed on screen in the last landscape_draw, in buffer pixels;
+	// ndamage past DAMAGE_MAX means too much to list, so damage the lot
+	struct rect damage[DAMAGE_MAX];
+	size_t ndamage;
+
+	struct view view; // as last drawn
+	uint32_t states; // what state_colours was made for
+	int64_t pointer_cell;
+	int32_t pointer_x, pointer_y; // [px]
+	double axis[2]; // scrolling not yet acted on
 	uint32_t pointer_held; // bool
+	uint32_t leap; // KEY_F jumps 2^leap generations
+	uint32_t pace, rate, per_frame; // as last passed on to the simulation
+
+	// held keys repeat off a timer, at the compositor's say
+	int repeat;
+	uint32_t repeat_key;
+	int32_t repeat_rate, repeat_delay; // [keys/s], [ms]
 
 	uint32_t running:1,
 		paused:1,
@@ -72,43 +233,187 @@ struct {
 	void (*brush)(struct landscape *landscape, int x, int y);
 } wl;
 
-enum { cell_off, cell_on, cell_cursor };
-uint32_t state_colours[] = {
+// A unit looks like the state of its cell, up to STATES_MAX of them, or like
+// one of the looks after: the cursor, and so on. Zoomed out, a unit with
+// anything alive in it is drawn in one of DENSITY_LEVELS greys after
+// cell_dense, by how full it is. There are LOOKS_MAX looks at most, for
+// raster_row_ssse3.
+enum { cell_off, cell_on, cell_cursor = STATES_MAX, cell_void, cell_ruled,
+	cell_dense };
+#define DENSITY_LEVELS 11
+#define LOOKS_MAX 32
+static const uint32_t look_colours[] = {
 	[cell_off]	= 0x80000000,
 	[cell_on]	= 0x80ffffff,
 	[cell_cursor]	= 0x80ffff00,
+	[cell_void]	= 0x80181828, // off the landscape
+	[cell_ruled]	= 0x80002a40, // dead, under a painted rule
+	0x80171717, 0x802e2e2e, 0x80454545, 0x805c5c5c, 0x80737373, 0x808b8b8b,
+	0x80a2a2a2, 0x80b9b9b9, 0x80d0d0d0, 0x80e7e7e7, 0x80ffffff,
 };
+// look_colours with a Generations rule's dying filled in, see palette_compile
+uint32_t state_colours[LOOKS_MAX];
 
 void frame_listener_done(void *data, struct wl_callback *callback, uint32_t time);
 
 void render(void *data);
-void landscape_draw(struct landscape *landscape, struct buffer *buffer);
+struct snap;
+void landscape_draw(struct landscape *landscape, const struct snap *snap,
+		struct buffer *buffer);
+int64_t view_cell(struct landscape *l, const struct view *v,
+		int32_t px, int32_t py);
 uint8_t landscape_get(struct landscape *b, int x, int y);
 void landscape_set(struct landscape *b, int x, int y, uint8_t val);
 size_t landscape_count_neighbours(struct landscape *b, int x, int y);
+void landscape_sync(struct landscape *l);
+void landscape_touch(struct landscape *l);
+const struct engine *landscape_engine(struct landscape *l);
+int landscape_write(struct landscape *l, const char *path);
 
 void brush_default(struct landscape *landscape, int x, int y);
 void brush_conway_glider(struct landscape *landscape, int x, int y);
+void brush_rule(struct landscape *landscape, int x, int y);
 
-void quotient_torus(struct landscape *l, int x, int y, size_t *X, size_t *Y);
+void quotient_torus(struct landscape *l, uint8_t *grid, size_t y0, size_t y1);
+void clamped(struct landscape *l, uint8_t *grid, size_t y0, size_t y1);
 // TODO:
-// void quotient_mobius(struct landscape *l, int x, int y, size_t *X, size_t *Y);
-// void quotient_klein(struct landscape *l, int x, int y, size_t *X, size_t *Y);
-// void quotient_schwartzschild(struct landscape *l, int x, int y, size_t *X, size_t *Y); lol????
+// void quotient_mobius(struct landscape *l, uint8_t *grid, size_t y0, size_t y1);
+// void quotient_klein(struct landscape *l, uint8_t *grid, size_t y0, size_t y1);
+// void quotient_schwartzschild(struct landscape *l, uint8_t *grid, size_t y0, size_t y1); lol????
+void landscape_fold(struct landscape *l, int x, int y, size_t *X, size_t *Y);
+void twod_larger(struct landscape *l, const uint8_t *from, uint8_t *to,
+		size_t y, uint32_t rule);
+
+// The cell at (x, y) of grid. x and y may step one cell into the halo.
+static inline uint8_t *landscape_at(struct landscape *l, uint8_t *grid,
+		long x, long y)
+{
+	return &grid[(y + 1) * (long)l->stride + x + 1];
+}
+
+static inline uint8_t *landscape_row(struct landscape *l, uint8_t *grid, long y)
+{
+	return landscape_at(l, grid, 0, y);
+}
+
+// The buffer the next generation is written to.
+static inline uint8_t *landscape_back(struct landscape *l)
+{
+	return l->show == l->flip ? l->flop : l->flip;
+}
 
 #define birth_bit(x) ((uint32_t)1 << (9 + (x)))
 #define survive_bit(x) ((uint32_t)1 << (x))
-void print_lifelike_rule(uint32_t rule)
+#define RULE_COUNTS 0x3ffff // the birth and survival bits
+// Generations rules carry their number of states above the counts, less two,
+// so 0 is the plain two state rule.
+#define rule_states(r) (2 + ((r) >> 18))
+#define states_bits(c) ((uint32_t)((c) - 2) << 18)
+// Write rule as `Bx/Sy`, or `Bx/Sy/Cn` with n states, into buf, which needs
+// room for 26 bytes.
+char *format_lifelike_rule(uint32_t rule, char *buf)
 {
-	fprintf(stdout, "B");
+	char *p = buf;
+
+	*p++ = 'B';
 	for (int i = 0; i < 9; i++)
 		if (!!(rule & birth_bit(i)))
-			fprintf(stdout, "%d", i);
-	fprintf(stdout, "/S");
+			*p++ = '0' + i;
+	*p++ = '/';
+	*p++ = 'S';
 	for (int i = 0; i < 9; i++)
 		if (!!(rule & (1 << i)))
-			fprintf(stdout, "%d", i);
-	fprintf(stdout, "\n");
+			*p++ = '0' + i;
+	if (rule_states(rule) > 2)
+		p += sprintf(p, "/C%u", rule_states(rule));
+	*p = 0;
+
+	return buf;
+}
+
+void print_lifelike_rule(uint32_t rule)
+{
+	char buf[32];
+	fprintf(stdout, "%s\n", format_lifelike_rule(rule, buf));
+}
+
+// `Cn` or `/Cn` after a rule: n states, 2..STATES_MAX. Returns the number of
+// characters used, 0 if there's none, or -1.
+static int parse_states(const char *s, uint32_t *states)
+{
+	const char *p = s + (*s == '/');
+	char *end;
+
+	if (*p != 'C' && *p != 'c')
+		return 0;
+	unsigned long c = strtoul(p + 1, &end, 10);
+	if (end == p + 1 || c < 2 || c > STATES_MAX)
+		return -1;
+	*states = c;
+	return end - s;
+}
+
+// Parse `Bx/Sy` (either order, either case), or Generations' `Bx/Sy/Cn`,
+// into a rule. Returns the number of characters used, or -1.
+int parse_lifelike_rule(const char *s, uint32_t *rule)
+{
+	const char *p = s;
+	uint32_t r = 0, c = 2;
+	int seen = 0, n;
+
+	while (*p == 'B' || *p == 'b' || *p == 'S' || *p == 's') {
+		int birth = *p == 'B' || *p == 'b';
+		if (seen & (birth ? 1 : 2))
+			return -1;
+		seen |= birth ? 1 : 2;
+
+		for (p++; *p >= '0' && *p <= '8'; p++)
+			r |= birth ? birth_bit(*p - '0') : survive_bit(*p - '0');
+		if (*p == '/' && seen != 3)
+			p++;
+	}
+	if (seen != 3)
+		return -1;
+	if ((n = parse_states(p, &c)) < 0)
+		return -1;
+	p += n;
+
+	*rule = r | states_bits(c);
+	return p - s;
+}
+
+// Parse a Larger than Life rule, `R5,C0,M1,S34..58,B34..45,NM`, into ltl.
+// Returns the number of characters used, or -1.
+int parse_ltl_rule(const char *s, struct ltl *ltl)
+{
+	struct ltl r;
+	unsigned c;
+	char n;
+	int len = 0;
+
+	if (sscanf(s, "R%u,C%u,M%u,S%u..%u,B%u..%u,N%c%n", &r.range, &c,
+			&r.middle, &r.smin, &r.smax, &r.bmin, &r.bmax, &n,
+			&len) != 8 || !len)
+		return -1;
+	if (r.range < 1 || r.range > LTL_RANGE_MAX || c == 1 || c > STATES_MAX
+			|| r.middle > 1 || (n != 'M' && n != 'N')
+			|| r.smin > r.smax || r.bmin > r.bmax)
+		return -1;
+	r.states = c ? c : 2;
+	r.shape = n == 'M' ? ltl_moore : ltl_neumann;
+
+	*ltl = r;
+	return len;
+}
+
+// The other way, into n bytes of buf; 48 is plenty.
+char *format_ltl_rule(const struct ltl *r, char *buf, size_t n)
+{
+	snprintf(buf, n, "R%u,C%u,M%u,S%u..%u,B%u..%u,N%c", r->range,
+			r->states > 2 ? r->states : 0, r->middle, r->smin,
+			r->smax, r->bmin, r->bmax,
+			r->shape == ltl_moore ? 'M' : 'N');
+	return buf;
 }
 
 uint32_t conway = birth_bit(3) | survive_bit(2) | survive_bit(3);
@@ -128,694 +433,6483 @@ uint32_t conway = birth_bit(3) | survive_bit(2) | survive_bit(3);
 //
 // Conway's Game of Life is the automata B3/S23. It encodes as:
 // 	[b8, b7, ... b0, s8, ... s0] = 18'b000001000 000001100
-void twod_life_like(struct landscape *landscape, int x, int y, uint32_t rule)
+//
+// The rule unpacks into two 16 entry tables indexed by neighbour count, which
+// is the shape a byte shuffle wants: next[0] for the dead, next[1] for the
+// living.
+//
+// Generations rules (`Bx/Sy/Cn`) give a cell n states. 0 is dead and 1 alive
+// as before, but a live cell that doesn't survive goes to 2 instead of 0, and
+// from there ages a state a generation until n - 1 goes back to 0. Only the
+// living count as neighbours, and the dying can't be born. Brian's Brain is
+// B2/S/C3.
+struct life_lut {
+	uint8_t next[2][16];
+	uint32_t states;
+} __attribute__((aligned(16)));
+
+static void life_lut_compile(uint32_t rule, struct life_lut *lut)
 {
-	size_t n = landscape_count_neighbours(landscape, x, y);
-
-	if (landscape_get(landscape, x, y))
-		landscape_set(landscape, x, y, !!(survive_bit(n) & rule));
-	else
-		landscape_set(landscape, x, y, !!(birth_bit(n) & rule));
+	memset(lut, 0, sizeof(*lut));
+	for (int k = 0; k < 9; k++) {
+		lut->next[0][k] = !!(rule & birth_bit(k));
+		lut->next[1][k] = !!(rule & survive_bit(k));
+	}
+	lut->states = rule_states(rule);
 }
 
-// The `rule` parameter is an 8 bit array that uses the states of the cell at
-// (x,y) and its neighbours, (x-1,y) and (x+1,y), to determine the state of the
-// cell at (x, y+1).
-// This is easier to see with an illustration. The following diagram defines the
-// rule, `a << 7 | b << 6 | ... | h`.
-//
-//			xxx xx- x-x x-- -xx -x- --x ---
-//			 a   b   c   d   e   f   g   h
-//
-// . XXX: it might be interesting to explore the dynamics when the a..h are
-// Bernoulli probabilities instead; i.e., take a = 1, b = 0.01, ..., h = 0.5
-// 	Maybe covered in [arXiv:1010.3133]
-void oned(struct landscape *landscape, int x, int y, uint32_t rule)
-{
-	if (y == 0 || x == 0 || x == landscape->width - 1) {
-		int v = landscape_get(landscape, x, y);
-		landscape_set(landscape, x, y, v);
-		return;
+// A life row kernel writes w cells of out from the haloed rows n, c and s
+// (north, centre and south). Cells are 0 or 1. If changed isn't NULL, each
+// LIFE_CHUNK cells that differ from c set their byte of it.
+#define LIFE_CHUNK 32
+
+typedef void (*life_row_fn)(uint8_t *out, const uint8_t *n, const uint8_t *c,
+		const uint8_t *s, size_t w, const struct life_lut *lut,
+		uint8_t *changed);
+
+static void life_row_scalar(uint8_t *out, const uint8_t *n, const uint8_t *c,
+		const uint8_t *s, size_t w, const struct life_lut *lut,
+		uint8_t *changed)
+{
+	for (size_t x = 0; x < w; x++) {
+		uint8_t k = n[x - 1] + n[x] + n[x + 1]
+			+ c[x - 1] + c[x + 1]
+			+ s[x - 1] + s[x] + s[x + 1];
+
+		out[x] = lut->next[c[x]][k];
 	}
 
-	uint8_t parent_pattern =  landscape_get(landscape,  x - 1, y-1) << 2
-				| landscape_get(landscape,  x,     y-1) << 1
-				| landscape_get(landscape,  x + 1, y-1);
+	if (!changed)
+		return;
+	for (size_t x0 = 0; x0 < w; x0 += LIFE_CHUNK) {
+		size_t x1 = x0 + LIFE_CHUNK < w ? x0 + LIFE_CHUNK : w, x = x0;
+		uint64_t d = 0, u, v;
+
+		for (; x + 8 <= x1; x += 8) {
+			memcpy(&u, out + x, 8);
+			memcpy(&v, c + x, 8);
+			d |= u ^ v;
+		}
+		for (; x < x1; x++)
+			d |= out[x] ^ c[x];
+		changed[x0 / LIFE_CHUNK] |= d != 0;
+	}
+}
 
-	uint8_t update = !!((rule & 0xff) & (1 << parent_pattern));
-	landscape_set(landscape, x, y, update);
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("ssse3")))
+static void life_row_ssse3(uint8_t *out, const uint8_t *n, const uint8_t *c,
+		const uint8_t *s, size_t w, const struct life_lut *lut,
+		uint8_t *changed)
+{
+	__m128i born = _mm_load_si128((const __m128i *)lut->next[0]);
+	__m128i keep = _mm_load_si128((const __m128i *)lut->next[1]);
+	size_t x = 0;
+
+#define L(p) _mm_loadu_si128((const __m128i *)(p))
+	// two vectors to a chunk
+	for (; x + LIFE_CHUNK <= w; x += LIFE_CHUNK) {
+		__m128i d = _mm_setzero_si128();
+		for (size_t i = x; i < x + LIFE_CHUNK; i += 16) {
+			__m128i k = _mm_add_epi8(
+				_mm_add_epi8(_mm_add_epi8(L(n + i - 1), L(n + i)),
+					     _mm_add_epi8(L(n + i + 1), L(c + i - 1))),
+				_mm_add_epi8(_mm_add_epi8(L(c + i + 1), L(s + i - 1)),
+					     _mm_add_epi8(L(s + i), L(s + i + 1))));
+			__m128i alive = L(c + i);
+			__m128i next = _mm_or_si128(
+				_mm_and_si128(alive, _mm_shuffle_epi8(keep, k)),
+				_mm_andnot_si128(alive, _mm_shuffle_epi8(born, k)));
+			_mm_storeu_si128((__m128i *)(out + i), next);
+			d = _mm_or_si128(d, _mm_xor_si128(next, alive));
+		}
+		if (changed)
+			changed[x / LIFE_CHUNK] |= _mm_movemask_epi8(
+				_mm_cmpeq_epi8(d, _mm_setzero_si128())) != 0xffff;
+	}
+#undef L
+	life_row_scalar(out + x, n + x, c + x, s + x, w - x, lut,
+			changed ? changed + x / LIFE_CHUNK : NULL);
 }
 
-static void buffer_release(void *data, struct wl_buffer *buf)
+__attribute__((target("avx2")))
+static void life_row_avx2(uint8_t *out, const uint8_t *n, const uint8_t *c,
+		const uint8_t *s, size_t w, const struct life_lut *lut,
+		uint8_t *changed)
 {
-	struct buffer *buffer = data;
-	buffer->busy = 0;
+	// vpshufb looks up within each 128 bit lane, so both lanes get a copy
+	__m256i born = _mm256_broadcastsi128_si256(
+			_mm_load_si128((const __m128i *)lut->next[0]));
+	__m256i keep = _mm256_broadcastsi128_si256(
+			_mm_load_si128((const __m128i *)lut->next[1]));
+	size_t x = 0;
+
+#define L(p) _mm256_loadu_si256((const __m256i *)(p))
+	// one vector to a chunk
+	for (; x + 32 <= w; x += 32) {
+		__m256i k = _mm256_add_epi8(
+			_mm256_add_epi8(_mm256_add_epi8(L(n + x - 1), L(n + x)),
+					_mm256_add_epi8(L(n + x + 1), L(c + x - 1))),
+			_mm256_add_epi8(_mm256_add_epi8(L(c + x + 1), L(s + x - 1)),
+					_mm256_add_epi8(L(s + x), L(s + x + 1))));
+		__m256i alive = L(c + x);
+		__m256i next = _mm256_or_si256(
+			_mm256_and_si256(alive, _mm256_shuffle_epi8(keep, k)),
+			_mm256_andnot_si256(alive, _mm256_shuffle_epi8(born, k)));
+		_mm256_storeu_si256((__m256i *)(out + x), next);
+		if (changed)
+			changed[x / LIFE_CHUNK] |= !_mm256_testz_si256(
+					_mm256_xor_si256(next, alive),
+					_mm256_xor_si256(next, alive));
+	}
+#undef L
+	// Dropping into legacy SSE with the upper halves dirty costs more than
+	// the whole row, so the tail goes scalar.
+	_mm256_zeroupper();
+	life_row_scalar(out + x, n + x, c + x, s + x, w - x, lut,
+			changed ? changed + x / LIFE_CHUNK : NULL);
 }
+#endif
+
+// The Generations kernels have the life kernels' shape, but count only the
+// cells that are 1 and age the rest. Anything at or past the last state,
+// left over from a rule with more, goes back to 0.
+static void gens_row_scalar(uint8_t *out, const uint8_t *n, const uint8_t *c,
+		const uint8_t *s, size_t w, const struct life_lut *lut,
+		uint8_t *changed)
+{
+	uint32_t states = lut->states;
 
-static const struct wl_buffer_listener buffer_listener = {
-	.release = buffer_release,
-};
+	for (size_t x = 0; x < w; x++) {
+		uint8_t k = (n[x - 1] == 1) + (n[x] == 1) + (n[x + 1] == 1)
+			+ (c[x - 1] == 1) + (c[x + 1] == 1)
+			+ (s[x - 1] == 1) + (s[x] == 1) + (s[x + 1] == 1);
+		uint32_t age = c[x] + 1u < states ? c[x] + 1u : 0;
 
-int shm_create_buffer(struct landscape *landscape, struct buffer *buffer)
-{
-	int fd, ret;
-	void *data;
-	char tmpname[] = "/tmp/cellular-XXXXXX";
-	struct wl_shm *shm = wl.shm;
-	uint32_t width = landscape->width * landscape->cell_width;
-	uint32_t height = landscape->height * landscape->cell_height;
-	uint32_t size = 4 * width * height; // 4 bytes per pixel
+		out[x] = c[x] == 0 ? lut->next[0][k]
+			: c[x] == 1 && lut->next[1][k] ? 1 : age;
+	}
 
-	// fd = memfd_create("cellularlandscapes-shared", MFD_CLOEXEC | MFD_ALLOW_SEALING);
-	fd = mkostemp(tmpname, O_CLOEXEC);
+	if (!changed)
+		return;
+	for (size_t x0 = 0; x0 < w; x0 += LIFE_CHUNK) {
+		size_t x1 = x0 + LIFE_CHUNK < w ? x0 + LIFE_CHUNK : w;
+		uint8_t d = 0;
 
-	if (fd > -1)
-		unlink(tmpname);
-	else
-		return -1;
+		for (size_t x = x0; x < x1; x++)
+			d |= out[x] ^ c[x];
+		changed[x0 / LIFE_CHUNK] |= d != 0;
+	}
+}
 
-	do {
-		ret = posix_fallocate(fd, 0, size);
-	} while (ret < 0 && errno == EINTR);
-	if (ret < 0) {
-		close(fd);
-		return -1;
+#if defined(__x86_64__) || defined(__i386__)
+// A cell that is 1 compares to all ones, i.e. -1, so the count is the
+// negated sum of the compares. The next state is picked with masks: born
+// from the table if dead, 1 if alive and kept, else the age.
+__attribute__((target("ssse3")))
+static void gens_row_ssse3(uint8_t *out, const uint8_t *n, const uint8_t *c,
+		const uint8_t *s, size_t w, const struct life_lut *lut,
+		uint8_t *changed)
+{
+	__m128i born = _mm_load_si128((const __m128i *)lut->next[0]);
+	__m128i keep = _mm_load_si128((const __m128i *)lut->next[1]);
+	__m128i one = _mm_set1_epi8(1), zero = _mm_setzero_si128();
+	__m128i last = _mm_set1_epi8(lut->states - 1);
+	size_t x = 0;
+
+#define A(p) _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p)), one)
+	for (; x + LIFE_CHUNK <= w; x += LIFE_CHUNK) {
+		__m128i d = zero;
+		for (size_t i = x; i < x + LIFE_CHUNK; i += 16) {
+			__m128i k = _mm_sub_epi8(zero, _mm_add_epi8(
+				_mm_add_epi8(_mm_add_epi8(A(n + i - 1), A(n + i)),
+					     _mm_add_epi8(A(n + i + 1), A(c + i - 1))),
+				_mm_add_epi8(_mm_add_epi8(A(c + i + 1), A(s + i - 1)),
+					     _mm_add_epi8(A(s + i), A(s + i + 1)))));
+			__m128i cur = _mm_loadu_si128((const __m128i *)(c + i));
+			__m128i dead = _mm_cmpeq_epi8(cur, zero);
+			__m128i kept = _mm_sub_epi8(zero, _mm_and_si128(
+					_mm_cmpeq_epi8(cur, one),
+					_mm_shuffle_epi8(keep, k)));
+			__m128i age = _mm_add_epi8(cur, one);
+			age = _mm_and_si128(age, _mm_cmpeq_epi8(
+					_mm_min_epu8(age, last), age));
+			__m128i next = _mm_or_si128(
+				_mm_and_si128(dead, _mm_shuffle_epi8(born, k)),
+				_mm_or_si128(_mm_and_si128(kept, one),
+					_mm_andnot_si128(_mm_or_si128(dead, kept),
+						age)));
+			_mm_storeu_si128((__m128i *)(out + i), next);
+			d = _mm_or_si128(d, _mm_xor_si128(next, cur));
+		}
+		if (changed)
+			changed[x / LIFE_CHUNK] |= _mm_movemask_epi8(
+				_mm_cmpeq_epi8(d, zero)) != 0xffff;
 	}
+#undef A
+	gens_row_scalar(out + x, n + x, c + x, s + x, w - x, lut,
+			changed ? changed + x / LIFE_CHUNK : NULL);
+}
 
-	data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-	if (data == MAP_FAILED) {
-		close(fd);
-		return -1;
+__attribute__((target("avx2")))
+static void gens_row_avx2(uint8_t *out, const uint8_t *n, const uint8_t *c,
+		const uint8_t *s, size_t w, const struct life_lut *lut,
+		uint8_t *changed)
+{
+	__m256i born = _mm256_broadcastsi128_si256(
+			_mm_load_si128((const __m128i *)lut->next[0]));
+	__m256i keep = _mm256_broadcastsi128_si256(
+			_mm_load_si128((const __m128i *)lut->next[1]));
+	__m256i one = _mm256_set1_epi8(1), zero = _mm256_setzero_si256();
+	__m256i last = _mm256_set1_epi8(lut->states - 1);
+	size_t x = 0;
+
+#define A(p) _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p)), one)
+	for (; x + 32 <= w; x += 32) {
+		__m256i k = _mm256_sub_epi8(zero, _mm256_add_epi8(
+			_mm256_add_epi8(_mm256_add_epi8(A(n + x - 1), A(n + x)),
+					_mm256_add_epi8(A(n + x + 1), A(c + x - 1))),
+			_mm256_add_epi8(_mm256_add_epi8(A(c + x + 1), A(s + x - 1)),
+					_mm256_add_epi8(A(s + x), A(s + x + 1)))));
+		__m256i cur = _mm256_loadu_si256((const __m256i *)(c + x));
+		__m256i age = _mm256_add_epi8(cur, one);
+		age = _mm256_and_si256(age, _mm256_cmpeq_epi8(
+				_mm256_min_epu8(age, last), age));
+		// the blends go last to first: kept, else born, else the age
+		__m256i next = _mm256_blendv_epi8(age, _mm256_shuffle_epi8(born, k),
+				_mm256_cmpeq_epi8(cur, zero));
+		next = _mm256_blendv_epi8(next, one, _mm256_sub_epi8(zero,
+				_mm256_and_si256(_mm256_cmpeq_epi8(cur, one),
+					_mm256_shuffle_epi8(keep, k))));
+		_mm256_storeu_si256((__m256i *)(out + x), next);
+		if (changed)
+			changed[x / LIFE_CHUNK] |= !_mm256_testz_si256(
+					_mm256_xor_si256(next, cur),
+					_mm256_xor_si256(next, cur));
+	}
+#undef A
+	_mm256_zeroupper();
+	gens_row_scalar(out + x, n + x, c + x, s + x, w - x, lut,
+			changed ? changed + x / LIFE_CHUNK : NULL);
+}
+#endif
+
+// Stochastic stepping draws its coins from Philox4x32-10 [Salmon et al.,
+// "Parallel random numbers: as easy as 1, 2, 3", SC11]: ten rounds of
+// multiplies and xors take a 128 bit counter and a 64 bit key to 128 bits
+// that pass BigCrush. Nothing carries over from one call to the next, so the
+// bits for any word of any row in any generation are had where they're
+// wanted, and a run comes out the same however it's split into threads or
+// tiles. The counter is (word, row, generation, its top bits << 8 | the pair
+// of planes), each call giving a word of two planes.
+#define NOISE_WORDS 64 // words of planes made at a time
+#define NOISE_ALPHA 8  // the first of alpha's planes; 1D odds have 0..7
+
+#define PHILOX_M0 0xd2511f53u
+#define PHILOX_M1 0xcd9e8d57u
+#define PHILOX_W0 0x9e3779b9u
+#define PHILOX_W1 0xbb67ae85u
+
+typedef void (*noise_fn)(uint64_t *a, uint64_t *b, size_t i0, size_t n,
+		const uint32_t ctr[3], uint32_t k0, uint32_t k1);
+
+static inline void philox(uint32_t x[4], uint32_t k0, uint32_t k1)
+{
+	for (int r = 0; r < 10; r++) {
+		uint64_t p0 = (uint64_t)PHILOX_M0 * x[0];
+		uint64_t p1 = (uint64_t)PHILOX_M1 * x[2];
+		x[0] = (uint32_t)(p1 >> 32) ^ x[1] ^ k0;
+		x[1] = (uint32_t)p1;
+		x[2] = (uint32_t)(p0 >> 32) ^ x[3] ^ k1;
+		x[3] = (uint32_t)p0;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
 	}
-	buffer->pixels = data;
+}
 
-	struct wl_shm_pool *pool = wl_shm_create_pool(shm, fd, size);
-	buffer->wl_buffer = wl_shm_pool_create_buffer(pool,
-			0, width, height, 4*width, WL_SHM_FORMAT_ARGB8888);
+// Words [i0, i0 + n) of a pair of planes, into a and b.
+static void noise_fill_scalar(uint64_t *a, uint64_t *b, size_t i0, size_t n,
+		const uint32_t ctr[3], uint32_t k0, uint32_t k1)
+{
+	for (size_t j = 0; j < n; j++) {
+		uint32_t x[4] = { i0 + j, ctr[0], ctr[1], ctr[2] };
+		philox(x, k0, k1);
+		a[j] = x[0] | (uint64_t)x[1] << 32;
+		b[j] = x[2] | (uint64_t)x[3] << 32;
+	}
+}
 
-	wl_buffer_add_listener(buffer->wl_buffer, &buffer_listener, buffer);
-	wl_shm_pool_destroy(pool);
-	close(fd);
+#if defined(__x86_64__) || defined(__i386__)
+// vpmuludq only multiplies the even 32 bit lanes, so the odd ones are
+// shifted down for a second go and the halves blended back.
+__attribute__((target("avx2")))
+static inline void philox_mulhilo_avx2(__m256i x, __m256i m,
+		__m256i *hi, __m256i *lo)
+{
+	__m256i e = _mm256_mul_epu32(x, m);
+	__m256i o = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
 
-	return 0;
+	*lo = _mm256_blend_epi32(e, _mm256_slli_epi64(o, 32), 0xaa);
+	*hi = _mm256_blend_epi32(_mm256_srli_epi64(e, 32), o, 0xaa);
 }
 
-// XXX: The double buffering is like never used
-struct buffer *landscape_next_buffer(struct landscape *landscape)
+// Counters i0 .. i0 + 8*NB - 1, eight to a vector, one per 32 bit lane.
+// A round is a chain of multiplies, so four vectors go at once to keep the
+// multiplier busy.
+#define PHILOX_NB 4
+
+__attribute__((target("avx2")))
+static inline void philox_avx2(uint64_t *a, uint64_t *b, size_t i0, int nb,
+		const uint32_t ctr[3], uint32_t k0, uint32_t k1)
 {
-	struct buffer *buf;
+	const __m256i m0 = _mm256_set1_epi32(PHILOX_M0);
+	const __m256i m1 = _mm256_set1_epi32(PHILOX_M1);
+	__m256i x[PHILOX_NB][4];
+
+	for (int v = 0; v < nb; v++) {
+		x[v][0] = _mm256_add_epi32(_mm256_set1_epi32(i0 + 8 * v),
+				_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		x[v][1] = _mm256_set1_epi32(ctr[0]);
+		x[v][2] = _mm256_set1_epi32(ctr[1]);
+		x[v][3] = _mm256_set1_epi32(ctr[2]);
+	}
 
-	if (!wl.buffers[0].busy)
-		buf = &wl.buffers[0];
-	else if (!wl.buffers[1].busy)
-		buf = &wl.buffers[1];
-	else
-		return NULL;
+	for (int r = 0; r < 10; r++) {
+		__m256i w0 = _mm256_set1_epi32(k0 + r * PHILOX_W0);
+		__m256i w1 = _mm256_set1_epi32(k1 + r * PHILOX_W1);
+		for (int v = 0; v < nb; v++) {
+			__m256i h0, l0, h1, l1;
+			philox_mulhilo_avx2(x[v][0], m0, &h0, &l0);
+			philox_mulhilo_avx2(x[v][2], m1, &h1, &l1);
+			x[v][0] = _mm256_xor_si256(_mm256_xor_si256(h1, x[v][1]), w0);
+			x[v][1] = l1;
+			x[v][2] = _mm256_xor_si256(_mm256_xor_si256(h0, x[v][3]), w1);
+			x[v][3] = l0;
+		}
+	}
 
-	if (!buf->wl_buffer)
-		if (shm_create_buffer(landscape, buf) < 0)
-			return NULL;
+	// Interleaving pairs lanes up into words 0 1 4 5 and 2 3 6 7; swapping
+	// the middle 128 bits puts them in order.
+	for (int v = 0; v < nb; v++) {
+		for (int h = 0; h < 2; h++) {
+			uint64_t *out = (h ? b : a) + 8 * v;
+			__m256i lo = _mm256_unpacklo_epi32(x[v][2 * h], x[v][2 * h + 1]);
+			__m256i hi = _mm256_unpackhi_epi32(x[v][2 * h], x[v][2 * h + 1]);
+			_mm256_storeu_si256((__m256i *)out,
+					_mm256_permute2x128_si256(lo, hi, 0x20));
+			_mm256_storeu_si256((__m256i *)(out + 4),
+					_mm256_permute2x128_si256(lo, hi, 0x31));
+		}
+	}
+}
 
-	return buf;
+__attribute__((target("avx2")))
+static void noise_fill_avx2(uint64_t *a, uint64_t *b, size_t i0, size_t n,
+		const uint32_t ctr[3], uint32_t k0, uint32_t k1)
+{
+	size_t j = 0;
+
+	for (; j + 8 * PHILOX_NB <= n; j += 8 * PHILOX_NB)
+		philox_avx2(a + j, b + j, i0 + j, PHILOX_NB, ctr, k0, k1);
+	for (; j + 8 <= n; j += 8)
+		philox_avx2(a + j, b + j, i0 + j, 1, ctr, k0, k1);
+	_mm256_zeroupper();
+	noise_fill_scalar(a + j, b + j, i0 + j, n - j, ctr, k0, k1);
 }
+#endif
 
-void clamped(struct landscape *l, int x, int y, size_t *X, size_t *Y) {
-	*X = x;
-	*Y = y;
+// follows the life kernel picked: -k scalar is scalar all through
+noise_fn noise_fill = noise_fill_scalar;
 
-	if (x < 0)
-		*X = 0;
-	if (y < 0)
-		*Y = 0;
-	if (x >= l->width)
-		*X = l->width-1;
-	if (y >= l->height)
-		*Y = l->height -1;
+// Planes [p0, p0 + np) of words [i0, i0 + n) of row y in generation g, plane
+// p0 + j at u + j*NOISE_WORDS; n is at most NOISE_WORDS.
+static void noise_planes(const struct landscape *l, uint64_t g, size_t y,
+		size_t i0, size_t n, int p0, int np, uint64_t *u)
+{
+	uint64_t spare[NOISE_WORDS];
+
+	for (int p = p0 & ~1; p < p0 + np; p += 2) {
+		uint32_t ctr[3] = { y, g, (uint32_t)(g >> 32) << 8 | p / 2 };
+		uint64_t *a = p >= p0 ? u + (p - p0) * NOISE_WORDS : spare;
+		uint64_t *b = p + 1 < p0 + np ? u + (p + 1 - p0) * NOISE_WORDS
+			: spare;
+		noise_fill(a, b, i0, n, ctr, l->key, l->key >> 32);
+	}
 }
 
-void quotient_torus(struct landscape *l, int x, int y, size_t *X, size_t *Y)
+// Planes a coin with chance p/256 takes; 0 and 256 need none.
+static inline int noise_depth(uint32_t p)
 {
-	if (y < 0)
-		*Y = l->height - 1;
-	else if (y > (int)l->height - 1)
-		*Y = 0;
-	else
-		*Y = y;
-
-	if (x > (int)l->width - 1)
-		*X = 0;
-	else if (x < 0)
-		*X = l->width - 1;
-	else
-		*X = x;
+	return p && p < 256 ? 8 - __builtin_ctz(p) : 0;
 }
 
-// Sample from the data of the currently displayed buffer
-uint8_t landscape_get(struct landscape *ls, int x, int y)
+// 64 coins at once, bit-sliced, each set with chance p/256: reading p's bits
+// from the bottom, a 1 ors in a fair coin and a 0 ands one in, which halves
+// the chance so far and adds a half or not. Trailing zeros of p do nothing
+// to a coin that's still 0, so they're skipped.
+static inline uint64_t noise_coin(const uint64_t *u, size_t k, uint32_t p)
 {
-	size_t X, Y;
+	uint64_t m = 0;
 
-	ls->quotient(ls, x, y, &X, &Y);
-	return ls->show[Y*ls->width + X];
+	for (int b = 8 - noise_depth(p); b < 8; b++, u += NOISE_WORDS)
+		m = p >> b & 1 ? m | u[k] : m & u[k];
+	return m;
 }
 
-// Set the next state
-void landscape_set(struct landscape *ls, int x, int y, uint8_t val)
+// Which cells of words [i0, i0 + n) of row y step in generation g; the rest
+// stay as they were.
+static void noise_follow(const struct landscape *l, uint64_t g, size_t y,
+		size_t i0, size_t n, uint64_t *m)
 {
-	size_t X, Y;
+	uint64_t u[8 * NOISE_WORDS];
 
-	ls->quotient(ls, x, y, &X, &Y);
-	if (ls->show == ls->flip)
-		ls->flop[Y*ls->width + X] = val;
-	else
-		ls->flip[Y*ls->width + X] = val;
+	if (l->alpha >= 256 || !l->alpha) {
+		memset(m, l->alpha ? 0xff : 0, n * sizeof(*m));
+		return;
+	}
+	noise_planes(l, g, y, i0, n, NOISE_ALPHA, noise_depth(l->alpha), u);
+	for (size_t j = 0; j < n; j++)
+		m[j] = noise_coin(u, j, l->alpha);
 }
 
-void landscape_set_front(struct landscape *ls, int x, int y, uint8_t val)
+// Put back the cells of a stepped row that weren't to step, from old.
+static void noise_keep_words(const struct landscape *l, uint64_t g, size_t y,
+		const uint64_t *old, uint64_t *out, size_t words)
 {
-	size_t X, Y;
+	uint64_t m[NOISE_WORDS];
 
-	ls->quotient(ls, x, y, &X, &Y);
-	ls->show[Y*ls->width + X] = val;
+	for (size_t i = 0; i < words; i += NOISE_WORDS) {
+		size_t n = words - i < NOISE_WORDS ? words - i : NOISE_WORDS;
+		noise_follow(l, g, y, i, n, m);
+		for (size_t j = 0; j < n; j++)
+			out[i + j] = (m[j] & out[i + j]) | (~m[j] & old[i + j]);
+	}
 }
 
-
-size_t landscape_count_neighbours(struct landscape *b, int x, int y)
+// Cells [0, w) of a row of bytes go back to old where bit x of m is clear.
+// Eight coins go to a byte mask at a time: multiplying copies the byte of
+// coins into each byte, byte i keeps only coin i, and adding 0x7f carries
+// into the top bit of those set. Branching per cell would miss half the time.
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define NOISE_SPREAD 0x0102040810204080 // cell x + i in byte 7 - i
+#else
+#define NOISE_SPREAD 0x8040201008040201 // cell x + i in byte i
+#endif
+
+typedef void (*blend_fn)(uint8_t *out, const uint8_t *old, const uint64_t *m,
+		size_t w);
+
+static void noise_blend_scalar(uint8_t *out, const uint8_t *old,
+		const uint64_t *m, size_t w)
 {
-	return	+ landscape_get(b, x,     y + 1)	// N
-		+ landscape_get(b, x + 1, y + 1)	// NE
-		+ landscape_get(b, x + 1, y)		// E
-		+ landscape_get(b, x + 1, y - 1)	// SE
-		+ landscape_get(b, x,     y - 1)	// S
-		+ landscape_get(b, x - 1, y + 1)	// SW
-		+ landscape_get(b, x - 1, y)		// W
-		+ landscape_get(b, x - 1, y - 1);	// NW
+	size_t x = 0;
+
+	for (; x + 8 <= w; x += 8) {
+		uint64_t b = m[x / 64] >> x % 64 & 0xff, o, c;
+		uint64_t s = b * 0x0101010101010101 & NOISE_SPREAD;
+		uint64_t t = ((s + 0x7f7f7f7f7f7f7f7f) | s) & 0x8080808080808080;
+		uint64_t f = (t >> 7) * 0xff;
+
+		memcpy(&o, out + x, 8);
+		memcpy(&c, old + x, 8);
+		o = (o & f) | (c & ~f);
+		memcpy(out + x, &o, 8);
+	}
+	for (; x < w; x++)
+		if (!(m[x / 64] >> x % 64 & 1))
+			out[x] = old[x];
 }
 
-void landscape_step(struct landscape *l)
+#if defined(__x86_64__) || defined(__i386__)
+// 32 coins at a time, each byte picking out its coin's byte and testing its
+// bit.
+__attribute__((target("avx2")))
+static void noise_blend_avx2(uint8_t *out, const uint8_t *old,
+		const uint64_t *m, size_t w)
 {
-	for (int x = 0; x < l->width; x++)
-		for (int y = 0; y < l->height; y++)
-			l->automata(l, x, y, l->rule);
-
-	l->show = l->show == l->flip ? l->flop : l->flip;
-
-	wl.redraw = 1;
+	const __m256i spread = _mm256_setr_epi8(
+			0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+			2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	const __m256i bit = _mm256_set1_epi64x(NOISE_SPREAD);
+	size_t x = 0;
+
+	for (; x + 32 <= w; x += 32) {
+		__m256i b = _mm256_shuffle_epi8(
+			_mm256_set1_epi32(m[x / 64] >> x % 64), spread);
+		__m256i f = _mm256_cmpeq_epi8(_mm256_and_si256(b, bit), bit);
+		_mm256_storeu_si256((__m256i *)(out + x), _mm256_blendv_epi8(
+			_mm256_loadu_si256((const __m256i *)(old + x)),
+			_mm256_loadu_si256((const __m256i *)(out + x)), f));
+	}
+	_mm256_zeroupper();
+	for (; x < w; x++)
+		if (!(m[x / 64] >> x % 64 & 1))
+			out[x] = old[x];
 }
+#endif
 
-void highlight_cell(struct landscape *landscape,
-		uint32_t *pixels, int x, int y)
+blend_fn noise_blend = noise_blend_scalar;
+
+// The same for a row of bytes, cell x taking word x/64's bit x%64 so that
+// every engine tosses the same coins.
+static void noise_keep_cells(const struct landscape *l, uint64_t g, size_t y,
+		const uint8_t *old, uint8_t *out, size_t w)
 {
-	size_t X, Y;
-	landscape->quotient(landscape, x, y, &X, &Y);
+	uint64_t m[NOISE_WORDS];
 
-	size_t tl = landscape->cell_width;
-	size_t w = landscape->width * tl; // pixels per row
-	for (size_t xx = x*tl; xx < (X + 1)*tl; xx++)
-		for (size_t yy = Y * tl * w; yy < (Y + 1) * tl * w; yy += w)
-			pixels[yy + xx] ^= 0x00000000;
+	for (size_t x0 = 0; x0 < w; x0 += 64 * NOISE_WORDS) {
+		size_t x1 = w - x0 < 64 * NOISE_WORDS ? w : x0 + 64 * NOISE_WORDS;
+		noise_follow(l, g, y, x0 / 64, (x1 - x0 + 63) / 64, m);
+		noise_blend(out + x0, old + x0, m, x1 - x0);
+	}
 }
 
-void highlight_neighbourhood(struct landscape *ls, uint32_t *pixels, int x, int y)
+static inline int landscape_noisy(const struct landscape *l)
 {
-	highlight_cell(ls, pixels, x - 1, y - 1);
-	highlight_cell(ls, pixels, x    , y - 1);
-	highlight_cell(ls, pixels, x + 1, y - 1);
-	highlight_cell(ls, pixels, x - 1, y);
-	highlight_cell(ls, pixels, x    , y);
-	highlight_cell(ls, pixels, x + 1, y);
-	highlight_cell(ls, pixels, x - 1, y + 1);
-	highlight_cell(ls, pixels, x    , y + 1);
-	highlight_cell(ls, pixels, x + 1, y + 1);
+	return l->alpha < 256 || l->odds_on;
 }
 
-// TODO: make this easier to read and understand
-void fill_cell(struct landscape *landscape,
-		uint32_t *pixels, size_t x, size_t y, uint8_t state)
-{
-	size_t tl = landscape->cell_width;
-	size_t w = landscape->width * tl; // pixels per row
+// Larger than Life's row loops, see ltl_square and ltl_diamond. Counts are
+// 16 bit: the most a neighbourhood can hold, (2 LTL_RANGE_MAX + 1)^2, fits,
+// and the prefix sums may wrap as only their differences are wanted.
+struct ltl_kernel {
+	// col += the living of in less those of out
+	void (*slide)(uint16_t *col, const uint8_t *in, const uint8_t *out,
+			size_t w);
+	// n = hi - lo
+	void (*diff)(uint16_t *n, const uint16_t *hi, const uint16_t *lo,
+			size_t w);
+	// a row's living, a, and diagonal sums dr and dl from the row above's
+	void (*diagonals)(uint8_t *a, uint16_t *dr, uint16_t *dl,
+			const uint8_t *row, const uint16_t *dr1,
+			const uint16_t *dl1, size_t w);
+	// n += the gains less the losses
+	void (*diamond)(uint16_t *n, const uint16_t *const gain[4],
+			const uint8_t *gain8, const uint16_t *const loss[4],
+			const uint8_t *loss8, size_t w);
+	// the next row from the counts, which take in the cell itself
+	void (*next)(uint8_t *out, const uint8_t *c, const uint16_t *n,
+			size_t w, const struct ltl *r);
+};
 
-	for (size_t xx = x*tl; xx < (x + 1)*tl; xx++)
-		for (size_t yy = y * tl * w; yy < (y + 1) * tl * w; yy += w)
-			pixels[yy + xx] = state_colours[state];
+static void ltl_slide_scalar(uint16_t *col, const uint8_t *in,
+		const uint8_t *out, size_t w)
+{
+	for (size_t x = 0; x < w; x++)
+		col[x] += (in[x] == 1) - (out[x] == 1);
 }
 
-void landscape_draw(struct landscape *landscape, struct buffer *buffer)
+static void ltl_diff_scalar(uint16_t *n, const uint16_t *hi,
+		const uint16_t *lo, size_t w)
 {
-	uint32_t *pixels = buffer->pixels;
-	uint8_t *state = landscape->show;
-
-	// TODO: only clear if state has changed
-	memset(pixels, 0x00, 4*landscape->width*landscape->height);
-	for (size_t y = 0; y < landscape->height; y++)
-		for (size_t x = 0; x < landscape->width; x++)
-			fill_cell(landscape, pixels, x, y,
-				state[y * landscape->width + x]);
-
-	if (wl.pointer_cell >= 0)
-		fill_cell(landscape, pixels,
-			wl.pointer_cell % landscape->width,
-			wl.pointer_cell/landscape->width, cell_cursor);
+	for (size_t x = 0; x < w; x++)
+		n[x] = hi[x] - lo[x];
 }
 
-void bind_globals(void *data, struct wl_registry *r, uint32_t name,
-		const char *interface, uint32_t version)
+static void ltl_diagonals_scalar(uint8_t *a, uint16_t *dr, uint16_t *dl,
+		const uint8_t *row, const uint16_t *dr1, const uint16_t *dl1,
+		size_t w)
 {
-	if (strcmp(interface, wl_compositor_interface.name) == 0) {
-		wl.compositor = wl_registry_bind(r, name,
-				&wl_compositor_interface, 4);
-	} else if (strcmp(interface, wl_shm_interface.name) == 0) {
-		wl.shm = wl_registry_bind(r, name, &wl_shm_interface, 1);
-	} else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
-		wl.wm = wl_registry_bind(r, name, &xdg_wm_base_interface, 1);
-	} else if (strcmp(interface, wl_seat_interface.name) == 0) {
-		wl.seat = wl_registry_bind(r, name, &wl_seat_interface, 4);
+	for (size_t x = 0; x < w; x++) {
+		a[x] = row[x] == 1;
+		dr[x] = a[x] + dr1[x - 1];
+		dl[x] = a[x] + dl1[x + 1];
 	}
 }
 
-void registry_remove(void *d, struct wl_registry *r, uint32_t n) { }
-
-static const struct wl_registry_listener registry_listener = {
-	.global = bind_globals,
-	.global_remove = registry_remove,
-};
-
-static void xdg_wm_base_ping(void *data, struct xdg_wm_base *wm, uint32_t serial)
+static void ltl_diamond_scalar(uint16_t *n, const uint16_t *const gain[4],
+		const uint8_t *gain8, const uint16_t *const loss[4],
+		const uint8_t *loss8, size_t w)
 {
-	xdg_wm_base_pong(wm, serial);
+	for (size_t x = 0; x < w; x++)
+		n[x] += gain[0][x] + gain[1][x] + gain[2][x] + gain[3][x]
+			+ gain8[x] - loss[0][x] - loss[1][x] - loss[2][x]
+			- loss[3][x] - loss8[x];
 }
 
-struct wl_callback_listener frame_listener = {
-	.done = frame_listener_done,
-};
-
-static void xdg_surf_config(void *data, struct xdg_surface *surf, uint32_t serial)
+// Without branches, the cells being as good as random.
+static void ltl_next_scalar(uint8_t *out, const uint8_t *c, const uint16_t *n,
+		size_t w, const struct ltl *r)
 {
-	xdg_surface_ack_configure(wl.xdg_surf, serial);
-
-	if (wl.wait_for_config) {
-		wl.wait_for_config = 0;
-		render(data);
+	uint32_t self = !r->middle, last = r->states - 1;
+	uint32_t bmin = r->bmin, bw = r->bmax - bmin;
+	uint32_t smin = r->smin, sw = r->smax - smin;
+
+	for (size_t x = 0; x < w; x++) {
+		uint8_t v = c[x], one = v == 1;
+		uint32_t k = n[x] - (self & one);
+		uint8_t born = (v == 0) & (k - bmin <= bw);
+		uint8_t kept = one & (k - smin <= sw);
+		uint8_t aging = (v != 0) & !kept & (v < last);
+		out[x] = born | kept | ((v + 1) & -aging);
 	}
 }
 
-static const struct xdg_surface_listener xdg_surf_listener = {
-	.configure = xdg_surf_config,
-};
-
-static const struct xdg_wm_base_listener wm_base_listener = {
-	.ping = xdg_wm_base_ping,
+static const struct ltl_kernel ltl_kernel_scalar = {
+	ltl_slide_scalar, ltl_diff_scalar, ltl_diagonals_scalar,
+	ltl_diamond_scalar, ltl_next_scalar,
 };
 
-void pointer_enter(void *data, struct wl_pointer *p, uint32_t serial, struct wl_surface *s,
-		wl_fixed_t x, wl_fixed_t y)
+#if defined(__x86_64__) || defined(__i386__)
+// 8 cells at a time, widened to 16 bits.
+__attribute__((target("ssse3")))
+static inline __m128i ltl_alive_ssse3(const uint8_t *p)
 {
-	struct landscape *b = data;
+	__m128i v = _mm_loadl_epi64((const __m128i *)p);
+	return _mm_unpacklo_epi8(_mm_and_si128(_mm_cmpeq_epi8(v,
+			_mm_set1_epi8(1)), _mm_set1_epi8(1)), _mm_setzero_si128());
+}
 
+#define L8(p) _mm_loadu_si128((const __m128i *)(p))
+#define S8(p, v) _mm_storeu_si128((__m128i *)(p), v)
 
-	int32_t tmp = wl_fixed_to_int(y)/30 * b->width + wl_fixed_to_int(x)/30;
-	if (tmp < 0 || tmp > b->width * b->height)
-		return;
-	wl.pointer_cell = tmp;
+__attribute__((target("ssse3")))
+static void ltl_slide_ssse3(uint16_t *col, const uint8_t *in,
+		const uint8_t *out, size_t w)
+{
+	size_t x = 0;
 
-	wl.redraw = 1;
+	for (; x + 8 <= w; x += 8)
+		S8(col + x, _mm_sub_epi16(_mm_add_epi16(L8(col + x),
+				ltl_alive_ssse3(in + x)), ltl_alive_ssse3(out + x)));
+	ltl_slide_scalar(col + x, in + x, out + x, w - x);
 }
 
-void pointer_motion(void *data, struct wl_pointer *p, uint32_t time,
-		wl_fixed_t x, wl_fixed_t y)
+__attribute__((target("ssse3")))
+static void ltl_diff_ssse3(uint16_t *n, const uint16_t *hi, const uint16_t *lo,
+		size_t w)
 {
-	struct landscape *l;
-	int32_t tmp;
+	size_t x = 0;
 
-	l = data;
-	tmp = wl_fixed_to_int(y)/l->cell_width
-		* l->width + wl_fixed_to_int(x)/l->cell_width;
-
-	if (tmp < 0 || tmp >= l->width * l->height)
-		return;
-	wl.pointer_cell = tmp;
+	for (; x + 8 <= w; x += 8)
+		S8(n + x, _mm_sub_epi16(L8(hi + x), L8(lo + x)));
+	ltl_diff_scalar(n + x, hi + x, lo + x, w - x);
+}
 
-	// XXX: This is so racy.
-	if (wl.pointer_held == BTN_LEFT)
-		l->show[tmp] = cell_on;
-	else if (wl.pointer_held == BTN_RIGHT)
-		l->show[tmp] = cell_off;
+__attribute__((target("ssse3")))
+static void ltl_diagonals_ssse3(uint8_t *a, uint16_t *dr, uint16_t *dl,
+		const uint8_t *row, const uint16_t *dr1, const uint16_t *dl1,
+		size_t w)
+{
+	size_t x = 0;
 
-	wl.redraw = 1;
+	for (; x + 8 <= w; x += 8) {
+		__m128i k = ltl_alive_ssse3(row + x);
+		_mm_storel_epi64((__m128i *)(a + x), _mm_packus_epi16(k, k));
+		S8(dr + x, _mm_add_epi16(k, L8(dr1 + x - 1)));
+		S8(dl + x, _mm_add_epi16(k, L8(dl1 + x + 1)));
+	}
+	ltl_diagonals_scalar(a + x, dr + x, dl + x, row + x, dr1 + x, dl1 + x,
+			w - x);
 }
 
-void pointer_leave(void *d, struct wl_pointer *p, uint32_t serial, struct wl_surface *s)
+__attribute__((target("ssse3")))
+static void ltl_diamond_ssse3(uint16_t *n, const uint16_t *const gain[4],
+		const uint8_t *gain8, const uint16_t *const loss[4],
+		const uint8_t *loss8, size_t w)
 {
+	const __m128i zero = _mm_setzero_si128();
+	size_t x = 0;
+
+	for (; x + 8 <= w; x += 8) {
+		__m128i g = _mm_add_epi16(
+			_mm_add_epi16(L8(gain[0] + x), L8(gain[1] + x)),
+			_mm_add_epi16(L8(gain[2] + x), L8(gain[3] + x)));
+		__m128i s = _mm_add_epi16(
+			_mm_add_epi16(L8(loss[0] + x), L8(loss[1] + x)),
+			_mm_add_epi16(L8(loss[2] + x), L8(loss[3] + x)));
+		g = _mm_add_epi16(g, _mm_unpacklo_epi8(_mm_loadl_epi64(
+				(const __m128i *)(gain8 + x)), zero));
+		s = _mm_add_epi16(s, _mm_unpacklo_epi8(_mm_loadl_epi64(
+				(const __m128i *)(loss8 + x)), zero));
+		S8(n + x, _mm_add_epi16(L8(n + x), _mm_sub_epi16(g, s)));
+	}
+	const uint16_t *g[4] = { gain[0] + x, gain[1] + x, gain[2] + x,
+		gain[3] + x };
+	const uint16_t *s[4] = { loss[0] + x, loss[1] + x, loss[2] + x,
+		loss[3] + x };
+	ltl_diamond_scalar(n + x, g, gain8 + x, s, loss8 + x, w - x);
 }
 
-void pointer_button(void *d, struct wl_pointer *p, uint32_t serial, uint32_t time,
-		uint32_t button, uint32_t state)
+// As ltl_next_avx2, with a <= b as a saturating a - b coming to 0.
+__attribute__((target("ssse3")))
+static void ltl_next_ssse3(uint8_t *out, const uint8_t *c, const uint16_t *n,
+		size_t w, const struct ltl *r)
 {
-	struct landscape *l = d;
+	const __m128i one = _mm_set1_epi16(1), zero = _mm_setzero_si128();
+	const __m128i self = _mm_set1_epi16(!r->middle);
+	const __m128i bmin = _mm_set1_epi16(r->bmin);
+	const __m128i bw = _mm_set1_epi16(r->bmax - r->bmin);
+	const __m128i smin = _mm_set1_epi16(r->smin);
+	const __m128i sw = _mm_set1_epi16(r->smax - r->smin);
+	const __m128i last = _mm_set1_epi16(r->states - 2);
+	size_t x = 0;
+
+#define LE(a, b) _mm_cmpeq_epi16(_mm_subs_epu16(a, b), zero)
+	for (; x + 8 <= w; x += 8) {
+		__m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64(
+				(const __m128i *)(c + x)), zero);
+		__m128i alive = _mm_cmpeq_epi16(v, one);
+		__m128i dead = _mm_cmpeq_epi16(v, zero);
+		__m128i k = _mm_sub_epi16(L8(n + x), _mm_and_si128(alive, self));
+		__m128i b = _mm_and_si128(dead, LE(_mm_sub_epi16(k, bmin), bw));
+		__m128i s = _mm_and_si128(alive, LE(_mm_sub_epi16(k, smin), sw));
+		__m128i a = _mm_andnot_si128(_mm_or_si128(s, dead), LE(v, last));
+		__m128i next = _mm_or_si128(
+			_mm_and_si128(_mm_or_si128(b, s), one),
+			_mm_and_si128(a, _mm_add_epi16(v, one)));
+		_mm_storel_epi64((__m128i *)(out + x),
+				_mm_packus_epi16(next, next));
+	}
+#undef LE
+	ltl_next_scalar(out + x, c + x, n + x, w - x, r);
+}
+#undef L8
+#undef S8
 
-	if (state == WL_POINTER_BUTTON_STATE_PRESSED)
-		wl.pointer_held = button;
-	else if (state == WL_POINTER_BUTTON_STATE_RELEASED)
-		wl.pointer_held = 0;
+static const struct ltl_kernel ltl_kernel_ssse3 = {
+	ltl_slide_ssse3, ltl_diff_ssse3, ltl_diagonals_ssse3,
+	ltl_diamond_ssse3, ltl_next_ssse3,
+};
 
+// 16 cells at a time, widened to 16 bits.
+__attribute__((target("avx2")))
+static inline __m256i ltl_alive_avx2(const uint8_t *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+	return _mm256_cvtepu8_epi16(_mm_and_si128(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8(1)), _mm_set1_epi8(1)));
+}
 
-	if (wl.pointer_cell >= 0 && wl.pointer_held == 0)
-		// draw on release
-		wl.brush(l, wl.pointer_cell % l->width, wl.pointer_cell/l->width);
+#define L16(p) _mm256_loadu_si256((const __m256i *)(p))
+#define S16(p, v) _mm256_storeu_si256((__m256i *)(p), v)
 
-	wl.redraw = 1;
+__attribute__((target("avx2")))
+static void ltl_slide_avx2(uint16_t *col, const uint8_t *in,
+		const uint8_t *out, size_t w)
+{
+	size_t x = 0;
+
+	for (; x + 16 <= w; x += 16)
+		S16(col + x, _mm256_sub_epi16(_mm256_add_epi16(L16(col + x),
+				ltl_alive_avx2(in + x)), ltl_alive_avx2(out + x)));
+	_mm256_zeroupper();
+	ltl_slide_scalar(col + x, in + x, out + x, w - x);
 }
 
-void pointer_axis(void *d, struct wl_pointer *p, uint32_t time, uint32_t axis,
-		wl_fixed_t value)
+__attribute__((target("avx2")))
+static void ltl_diff_avx2(uint16_t *n, const uint16_t *hi, const uint16_t *lo,
+		size_t w)
 {
+	size_t x = 0;
+
+	for (; x + 16 <= w; x += 16)
+		S16(n + x, _mm256_sub_epi16(L16(hi + x), L16(lo + x)));
+	_mm256_zeroupper();
+	ltl_diff_scalar(n + x, hi + x, lo + x, w - x);
 }
 
-void pointer_frame(void *d, struct wl_pointer *p)
+__attribute__((target("avx2")))
+static void ltl_diagonals_avx2(uint8_t *a, uint16_t *dr, uint16_t *dl,
+		const uint8_t *row, const uint16_t *dr1, const uint16_t *dl1,
+		size_t w)
 {
+	size_t x = 0;
+
+	for (; x + 16 <= w; x += 16) {
+		__m128i v = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(
+				(const __m128i *)(row + x)), _mm_set1_epi8(1)),
+				_mm_set1_epi8(1));
+		__m256i k = _mm256_cvtepu8_epi16(v);
+		_mm_storeu_si128((__m128i *)(a + x), v);
+		S16(dr + x, _mm256_add_epi16(k, L16(dr1 + x - 1)));
+		S16(dl + x, _mm256_add_epi16(k, L16(dl1 + x + 1)));
+	}
+	_mm256_zeroupper();
+	ltl_diagonals_scalar(a + x, dr + x, dl + x, row + x, dr1 + x, dl1 + x,
+			w - x);
 }
 
-void pointer_axis_source(void *d, struct wl_pointer *p, uint32_t a)
+__attribute__((target("avx2")))
+static void ltl_diamond_avx2(uint16_t *n, const uint16_t *const gain[4],
+		const uint8_t *gain8, const uint16_t *const loss[4],
+		const uint8_t *loss8, size_t w)
 {
+	size_t x = 0;
+
+	for (; x + 16 <= w; x += 16) {
+		__m256i g = _mm256_add_epi16(
+			_mm256_add_epi16(L16(gain[0] + x), L16(gain[1] + x)),
+			_mm256_add_epi16(L16(gain[2] + x), L16(gain[3] + x)));
+		__m256i s = _mm256_add_epi16(
+			_mm256_add_epi16(L16(loss[0] + x), L16(loss[1] + x)),
+			_mm256_add_epi16(L16(loss[2] + x), L16(loss[3] + x)));
+		g = _mm256_add_epi16(g, _mm256_cvtepu8_epi16(_mm_loadu_si128(
+				(const __m128i *)(gain8 + x))));
+		s = _mm256_add_epi16(s, _mm256_cvtepu8_epi16(_mm_loadu_si128(
+				(const __m128i *)(loss8 + x))));
+		S16(n + x, _mm256_add_epi16(L16(n + x), _mm256_sub_epi16(g, s)));
+	}
+	_mm256_zeroupper();
+	const uint16_t *g[4] = { gain[0] + x, gain[1] + x, gain[2] + x,
+		gain[3] + x };
+	const uint16_t *s[4] = { loss[0] + x, loss[1] + x, loss[2] + x,
+		loss[3] + x };
+	ltl_diamond_scalar(n + x, g, gain8 + x, s, loss8 + x, w - x);
 }
 
-void pointer_axis_stop(void *d, struct wl_pointer *p, uint32_t t, uint32_t a)
+// The bands as unsigned compares: k - min <= max - min, min_epu16 standing
+// in for the missing <=.
+__attribute__((target("avx2")))
+static void ltl_next_avx2(uint8_t *out, const uint8_t *c, const uint16_t *n,
+		size_t w, const struct ltl *r)
 {
+	const __m256i one = _mm256_set1_epi16(1), zero = _mm256_setzero_si256();
+	const __m256i self = _mm256_set1_epi16(!r->middle);
+	const __m256i bmin = _mm256_set1_epi16(r->bmin);
+	const __m256i bw = _mm256_set1_epi16(r->bmax - r->bmin);
+	const __m256i smin = _mm256_set1_epi16(r->smin);
+	const __m256i sw = _mm256_set1_epi16(r->smax - r->smin);
+	const __m256i last = _mm256_set1_epi16(r->states - 2);
+	size_t x = 0;
+
+#define LE(a, b) _mm256_cmpeq_epi16(_mm256_min_epu16(a, b), a)
+	for (; x + 16 <= w; x += 16) {
+		__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+				(const __m128i *)(c + x)));
+		__m256i alive = _mm256_cmpeq_epi16(v, one);
+		__m256i k = _mm256_sub_epi16(L16(n + x),
+				_mm256_and_si256(alive, self));
+		__m256i b = LE(_mm256_sub_epi16(k, bmin), bw);
+		__m256i s = LE(_mm256_sub_epi16(k, smin), sw);
+		b = _mm256_and_si256(b, _mm256_cmpeq_epi16(v, zero));
+		s = _mm256_and_si256(s, alive);
+		// aging: alive and not kept, or dying, short of the last state
+		__m256i a = _mm256_andnot_si256(_mm256_or_si256(s,
+				_mm256_cmpeq_epi16(v, zero)), LE(v, last));
+		__m256i next = _mm256_or_si256(
+			_mm256_and_si256(_mm256_or_si256(b, s), one),
+			_mm256_and_si256(a, _mm256_add_epi16(v, one)));
+		// packus works within lanes, so the halves are gathered after
+		next = _mm256_permute4x64_epi64(
+				_mm256_packus_epi16(next, next), 0x08);
+		_mm_storeu_si128((__m128i *)(out + x),
+				_mm256_castsi256_si128(next));
+	}
+#undef LE
+	_mm256_zeroupper();
+	ltl_next_scalar(out + x, c + x, n + x, w - x, r);
 }
+#undef L16
+#undef S16
 
-void pointer_axis_discrete(void *d, struct wl_pointer *p, uint32_t a, int32_t discrete)
+static const struct ltl_kernel ltl_kernel_avx2 = {
+	ltl_slide_avx2, ltl_diff_avx2, ltl_diagonals_avx2,
+	ltl_diamond_avx2, ltl_next_avx2,
+};
+#endif
+
+const struct ltl_kernel *ltl_kernel = &ltl_kernel_scalar; // goes with life_row
+
+struct life_kernel {
+	const char *name;
+	life_row_fn row, gens;
+} life_kernels[] = {
+	{ "scalar", life_row_scalar, gens_row_scalar },
+#if defined(__x86_64__) || defined(__i386__)
+	{ "ssse3", life_row_ssse3, gens_row_ssse3 },
+	{ "avx2", life_row_avx2, gens_row_avx2 },
+#endif
+};
+
+life_row_fn life_row = life_row_scalar;
+life_row_fn gens_row = gens_row_scalar; // goes with life_row
+
+const char *life_row_name(void)
 {
+	for (size_t i = 0; i < sizeof(life_kernels)/sizeof(*life_kernels); i++)
+		if (life_kernels[i].row == life_row)
+			return life_kernels[i].name;
+	return "?";
 }
 
-struct wl_pointer_listener wl_pointer_listener = {
-	.enter          = pointer_enter,
-	.leave          = pointer_leave,
-	.motion         = pointer_motion,
-	.button         = pointer_button,
-	.axis           = pointer_axis,
-	.frame          = pointer_frame,
-	.axis_source    = pointer_axis_source,
-	.axis_stop      = pointer_axis_stop,
-	.axis_discrete  = pointer_axis_discrete,
+// Whether the CPU has the instructions the kernel of that name is written in.
+static int life_kernel_runs(const char *name)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (!strcmp(name, "ssse3"))
+		return __builtin_cpu_supports("ssse3");
+	if (!strcmp(name, "avx2"))
+		return __builtin_cpu_supports("avx2");
+#endif
+	return 1;
+}
+
+// Pick the widest kernel the CPU can run, or the one asked for by name:
+// -EINVAL when there's none of that name, -ENOTSUP when the CPU can't run it.
+int life_row_select(const char *name)
+{
+	size_t n = sizeof(life_kernels)/sizeof(*life_kernels), i;
+
+	if (name) {
+		for (i = 0; i < n && strcmp(name, life_kernels[i].name); i++)
+			;
+		if (i == n)
+			return -EINVAL;
+		if (!life_kernel_runs(name))
+			return -ENOTSUP;
+		life_row = life_kernels[i].row;
+	} else {
+		// narrowest first
+		for (i = 0; i < n; i++)
+			if (life_kernel_runs(life_kernels[i].name))
+				life_row = life_kernels[i].row;
+	}
+	for (i = 0; i < n; i++)
+		if (life_kernels[i].row == life_row)
+			gens_row = life_kernels[i].gens;
+
+	noise_fill = noise_fill_scalar;
+	noise_blend = noise_blend_scalar;
+	ltl_kernel = &ltl_kernel_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+	if (life_row == life_row_ssse3)
+		ltl_kernel = &ltl_kernel_ssse3;
+	if (life_row == life_row_avx2) {
+		noise_fill = noise_fill_avx2;
+		noise_blend = noise_blend_avx2;
+		ltl_kernel = &ltl_kernel_avx2;
+	}
+#endif
+	return 0;
+}
+
+// The automata update a whole row at a time, reading neighbours straight out
+// of the haloed rows above and below.
+void twod_life_like(struct landscape *landscape, const uint8_t *from,
+		uint8_t *to, size_t y, uint32_t rule)
+{
+	const uint8_t *c = landscape_row(landscape, (uint8_t *)from, y);
+	struct life_lut lut;
+
+	life_lut_compile(rule, &lut);
+	(lut.states > 2 ? gens_row : life_row)(landscape_row(landscape, to, y),
+			c - landscape->stride, c, c + landscape->stride,
+			landscape->width, &lut, NULL);
+}
+
+// The `rule` parameter is an 8 bit array that uses the states of the cell at
+// (x,y) and its neighbours, (x-1,y) and (x+1,y), to determine the state of the
+// cell at (x, y+1).
+// This is easier to see with an illustration. The following diagram defines the
+// rule, `a << 7 | b << 6 | ... | h`.
+//
+//			xxx xx- x-x x-- -xx -x- --x ---
+//			 a   b   c   d   e   f   g   h
+//
+// The oned engine can also take the a..h as Bernoulli probabilities instead,
+// e.g. -a 1,0.01,...,0.5; see oned_row. [arXiv:1010.3133]
+//
+// The cells past either edge are the quotient's, read out of the halo: on a
+// torus the row wraps, clamped the edge cell is its own neighbour.
+void oned(struct landscape *landscape, const uint8_t *from, uint8_t *to,
+		size_t y, uint32_t rule)
+{
+	const uint8_t *c = landscape_row(landscape, (uint8_t *)from, y);
+	const uint8_t *n = c - landscape->stride;
+	uint8_t *out = landscape_row(landscape, to, y);
+	size_t w = landscape->width;
+
+	if (y == 0) {
+		memcpy(out, c, w);
+		return;
+	}
+
+	for (size_t x = 0; x < w; x++) {
+		uint8_t parent_pattern = n[x - 1] << 2 | n[x] << 1 | n[x + 1];
+		out[x] = (rule & 0xff) >> parent_pattern & 1;
+	}
+}
+
+static void buffer_release(void *data, struct wl_buffer *buf)
+{
+	struct buffer *buffer = data;
+	buffer->busy = 0;
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+	.release = buffer_release,
 };
 
-void seat_name(void *data, struct wl_seat *seat, const char *name)
+// Every buffer lives in the one wl_shm_pool, on a memfd sealed against
+// shrinking so the compositor never has the memory pulled from under it.
+// Buffer i is at base + i*slot. The pool can only grow: when a window no
+// longer fits a slot, the slots double and move to wherever nothing the
+// compositor holds is, and buffers follow as they're released.
+struct {
+	struct wl_shm_pool *pool;
+	int fd;
+	uint8_t *data;
+	size_t size, slot, base; // [bytes]
+} shmpool;
+
+static int shm_open_pool(size_t size)
 {
+	int fd = memfd_create("cellularlandscapes", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+	if (fd > -1) {
+		fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL);
+	} else {
+		char tmpname[] = "/tmp/cellular-XXXXXX";
+		fd = mkostemp(tmpname, O_CLOEXEC);
+		if (fd < 0)
+			return -1;
+		unlink(tmpname);
+	}
+
+	if (ftruncate(fd, size) < 0) {
+		close(fd);
+		return -1;
+	}
+	shmpool.data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (shmpool.data == MAP_FAILED) {
+		close(fd);
+		return -1;
+	}
+
+	shmpool.pool = wl_shm_create_pool(wl.shm, fd, size);
+	shmpool.fd = fd;
+	shmpool.size = size;
+	return 0;
 }
 
-static void keyboard_handle_keymap(void *data, struct wl_keyboard *keyboard, uint32_t format, int fd, uint32_t size)
+static int shm_grow_pool(size_t size)
 {
-	close(fd);
+	if (size <= shmpool.size)
+		return 0;
+	if (ftruncate(shmpool.fd, size) < 0)
+		return -1;
+
+	void *data = mremap(shmpool.data, shmpool.size, size, MREMAP_MAYMOVE);
+	if (data == MAP_FAILED)
+		return -1;
+	shmpool.data = data;
+	shmpool.size = size;
+	wl_shm_pool_resize(shmpool.pool, size);
+
+	for (size_t i = 0; i < wl.nbuffers; i++)
+		if (wl.buffers[i].wl_buffer)
+			wl.buffers[i].pixels = (uint32_t *)(shmpool.data
+					+ wl.buffers[i].offset);
+	return 0;
 }
 
-static void keyboard_handle_enter(void *data, struct wl_keyboard *keyboard, uint32_t serial, struct wl_surface *surface, struct wl_array *keys)
+// Make room for buffers of size bytes.
+static int shm_fit(size_t size)
 {
+	size_t page = sysconf(_SC_PAGESIZE), slot = shmpool.slot;
+
+	if (size <= slot)
+		return 0;
+	if (!slot)
+		slot = page;
+	while (slot < size)
+		slot *= 2;
+
+	if (!shmpool.pool) {
+		if (shm_open_pool(BUFFERS_MAX * slot) < 0)
+			return -1;
+	} else {
+		size_t base = 0;
+		for (size_t i = 0; i < wl.nbuffers; i++)
+			if (wl.buffers[i].busy)
+				base = shmpool.size;
+		if (shm_grow_pool(base + BUFFERS_MAX * slot) < 0)
+			return -1;
+		shmpool.base = base;
+	}
+	shmpool.slot = slot;
+	return 0;
 }
 
-static void keyboard_handle_leave(void *data, struct wl_keyboard *keyboard, uint32_t serial, struct wl_surface *surface)
+// (Re)make buffer, which the compositor isn't holding, the size of the
+// window in v.
+int shm_create_buffer(struct buffer *buffer, const struct view *v)
 {
+	uint32_t width = v->pw;
+	uint32_t height = v->ph;
+	size_t size = (size_t)4 * width * height; // 4 bytes per pixel
+
+	if (shm_fit(size) < 0)
+		return -1;
+	size_t offset = shmpool.base + (buffer - wl.buffers) * shmpool.slot;
+
+	int ret;
+	do {
+		ret = posix_fallocate(shmpool.fd, offset, size);
+	} while (ret == EINTR);
+	if (ret)
+		return -1;
+
+	// units are at least a pixel; the empty view makes the first draw
+	// paint everything
+	if (width * height > buffer->width * buffer->height) {
+		uint8_t *cells = realloc(buffer->cells, (size_t)width * height);
+		if (!cells)
+			return -1;
+		buffer->cells = cells;
+	}
+	buffer->view = (struct view){0};
+
+	if (buffer->wl_buffer)
+		wl_buffer_destroy(buffer->wl_buffer);
+	buffer->wl_buffer = wl_shm_pool_create_buffer(shmpool.pool,
+			offset, width, height, 4*width, WL_SHM_FORMAT_ARGB8888);
+	wl_buffer_add_listener(buffer->wl_buffer, &buffer_listener, buffer);
+
+	buffer->pixels = (uint32_t *)(shmpool.data + offset);
+	buffer->offset = offset;
+	buffer->width = width;
+	buffer->height = height;
+	return 0;
 }
 
+// A buffer the compositor isn't holding, the size of the window in v, or NULL
+// if it's holding all of them.
+struct buffer *landscape_next_buffer(const struct view *v)
+{
+	struct buffer *buf = NULL;
 
-static void keyboard_handle_modifiers(void *data, struct wl_keyboard *keyboard, uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group)
+	for (size_t i = 0; i < wl.nbuffers && !buf; i++)
+		if (!wl.buffers[i].busy)
+			buf = &wl.buffers[i];
+	if (!buf) {
+		if (wl.nbuffers == BUFFERS_MAX)
+			return NULL;
+		buf = &wl.buffers[wl.nbuffers++];
+	}
+
+	if (!buf->wl_buffer || buf->width != v->pw || buf->height != v->ph
+			|| buf->offset != shmpool.base
+				+ (buf - wl.buffers) * shmpool.slot)
+		if (shm_create_buffer(buf, v) < 0) {
+			fprintf(stderr, "couldn't make a %ux%u buffer\n",
+					v->pw, v->ph);
+			return NULL;
+		}
+
+	return buf;
+}
+
+// The quotients fill the halo of grid: each edge cell's neighbours that fall
+// off the landscape. Only the halo fed by rows [y0, y1) is touched, so
+// stripes of the landscape can be finished off independently.
+void clamped(struct landscape *l, uint8_t *grid, size_t y0, size_t y1)
 {
+	size_t w = l->width, h = l->height;
+
+	for (size_t y = y0; y < y1; y++) {
+		uint8_t *row = landscape_row(l, grid, y);
+		row[-1] = row[0];
+		row[w] = row[w - 1];
+	}
+	if (y0 == 0 && y1 > 0)
+		memcpy(landscape_at(l, grid, -1, -1), landscape_at(l, grid, -1, 0), w + 2);
+	if (y1 == h && y0 < h)
+		memcpy(landscape_at(l, grid, -1, h), landscape_at(l, grid, -1, h - 1), w + 2);
 }
 
-void landscape_debug(struct landscape *l, int32_t cell)
+void quotient_torus(struct landscape *l, uint8_t *grid, size_t y0, size_t y1)
 {
-	int x = wl.pointer_cell % l->width;
-	int y = wl.pointer_cell/l->width;
+	size_t w = l->width, h = l->height;
 
-	fprintf(stderr, "%d %d %d\n%d %d %d\n%d %d %d\n\n",
-			landscape_get(l, x - 1, y - 1),
-			landscape_get(l, x,     y - 1),
-			landscape_get(l, x + 1, y - 1),
+	for (size_t y = y0; y < y1; y++) {
+		uint8_t *row = landscape_row(l, grid, y);
+		row[-1] = row[w - 1];
+		row[w] = row[0];
+	}
+	if (y1 == h && y0 < h)
+		memcpy(landscape_at(l, grid, -1, -1), landscape_at(l, grid, -1, h - 1), w + 2);
+	if (y0 == 0 && y1 > 0)
+		memcpy(landscape_at(l, grid, -1, h), landscape_at(l, grid, -1, 0), w + 2);
+}
 
-			landscape_get(l, x - 1, y),
-			landscape_get(l, x,     y),
-			landscape_get(l, x + 1, y),
+// Map a point just off the landscape back on to it, the same way the
+// quotient's halo does. This is for the odd lookup (brushes, the debugger),
+// not for stepping.
+void landscape_fold(struct landscape *l, int x, int y, size_t *X, size_t *Y)
+{
+	int w = l->width, h = l->height;
+
+	if (l->quotient == quotient_torus) {
+		*X = (x % w + w) % w;
+		*Y = (y % h + h) % h;
+	} else {
+		*X = x < 0 ? 0 : x >= w ? w - 1 : x;
+		*Y = y < 0 ? 0 : y >= h ? h - 1 : y;
+	}
+}
 
-			landscape_get(l, x - 1, y + 1),
-			landscape_get(l, x,     y + 1),
-			landscape_get(l, x + 1, y + 1));
+// Sample from the data of the currently displayed buffer
+uint8_t landscape_get(struct landscape *ls, int x, int y)
+{
+	size_t X, Y;
+
+	landscape_fold(ls, x, y, &X, &Y);
+	return *landscape_at(ls, ls->show, X, Y);
 }
 
-static void keyboard_handle_key(void *data, struct wl_keyboard *keyboard,
-		    uint32_t serial, uint32_t time, uint32_t key,
-		    uint32_t state)
+// Set the next state
+void landscape_set(struct landscape *ls, int x, int y, uint8_t val)
 {
-	struct landscape *ls = data;
+	size_t X, Y;
 
-	if (key == KEY_R && state) {
-		memset(ls->flip, 0, ls->width * ls->height);
-		memset(ls->flop, 0, ls->width * ls->height);
-		if (ls->automata == oned)
-			ls->show[ls->width/2] = 1;
-		wl.paused = 1;
+	landscape_fold(ls, x, y, &X, &Y);
+	*landscape_at(ls, landscape_back(ls), X, Y) = val;
+}
+
+void landscape_set_front(struct landscape *ls, int x, int y, uint8_t val)
+{
+	size_t X, Y;
+
+	landscape_fold(ls, x, y, &X, &Y);
+	landscape_sync(ls);
+	*landscape_at(ls, ls->show, X, Y) = val;
+	landscape_touch(ls);
+}
+
+// The living about (x, y): the eight nearest, or under twod_larger those in
+// the rule's range and shape. Cell by cell, for checking the steppers.
+size_t landscape_count_neighbours(struct landscape *b, int x, int y)
+{
+	if (b->automata == twod_larger) {
+		int r = b->ltl.range;
+		size_t n = 0;
+
+		for (int dy = -r; dy <= r; dy++)
+			for (int dx = -r; dx <= r; dx++) {
+				if (b->ltl.shape == ltl_neumann
+						&& abs(dx) + abs(dy) > r)
+					continue;
+				if (!dx && !dy && !b->ltl.middle)
+					continue;
+				n += landscape_get(b, x + dx, y + dy) == 1;
+			}
+		return n;
+	}
+
+	return	+ landscape_get(b, x,     y + 1)	// N
+		+ landscape_get(b, x + 1, y + 1)	// NE
+		+ landscape_get(b, x + 1, y)		// E
+		+ landscape_get(b, x + 1, y - 1)	// SE
+		+ landscape_get(b, x,     y - 1)	// S
+		+ landscape_get(b, x - 1, y + 1)	// SW
+		+ landscape_get(b, x - 1, y)		// W
+		+ landscape_get(b, x - 1, y - 1);	// NW
+}
+
+// Bring `show` up to date before it is read or painted.
+void landscape_sync(struct landscape *l)
+{
+	if (l->show_stale && landscape_engine(l)->unpack)
+		landscape_engine(l)->unpack(l);
+	l->show_stale = 0;
+}
+
+// `show` was painted, so the engine's own copy is behind.
+void landscape_touch(struct landscape *l)
+{
+	l->engine_stale = 1;
+}
+
+static inline uint32_t landscape_rule(struct landscape *l, uint8_t i)
+{
+	return i ? l->palette[i] : l->rule;
+}
+
+// The palette slot for rule, taking a free one if it's new; slots no tile
+// uses any more are free. -1 if all RULES_MAX are in use.
+static int rules_index(struct landscape *l, uint32_t rule)
+{
+	size_t n = l->rules_w * ((l->height + RULE_TILE - 1) / RULE_TILE);
+	uint8_t used[RULES_MAX] = { 1 };
+
+	if (rule == l->rule)
+		return 0;
+	for (size_t i = 0; i < n; i++)
+		used[l->rules[i]] = 1;
+	for (int i = 1; i < RULES_MAX; i++)
+		if (used[i] && l->palette[i] == rule)
+			return i;
+	for (int i = 1; i < RULES_MAX; i++)
+		if (!used[i])
+			return l->palette[i] = rule, i;
+	return -1;
+}
+
+// Paint the tiles over cells [x, x+w) x [y, y+h) with rule. Painting the
+// landscape's own rule hands them back to it, so they follow it from then
+// on. Engines that cache anything about the cells are told, as for any
+// painting. Larger than Life steps by its one rule alone, so there it's
+// -ENOTSUP.
+int landscape_paint_rule(struct landscape *l, size_t x, size_t y,
+		size_t w, size_t h, uint32_t rule)
+{
+	size_t th = (l->height + RULE_TILE - 1) / RULE_TILE;
+
+	if (l->automata == twod_larger)
+		return -ENOTSUP;
+	if (!l->rules) {
+		l->rules_w = (l->width + RULE_TILE - 1) / RULE_TILE;
+		l->rules = calloc(l->rules_w * th, 1);
+		if (!l->rules)
+			return -ENOMEM;
+	}
+
+	int i = rules_index(l, rule);
+	if (i < 0)
+		return -1;
+
+	landscape_sync(l);
+	size_t tx1 = (x + w + RULE_TILE - 1) / RULE_TILE;
+	size_t ty1 = (y + h + RULE_TILE - 1) / RULE_TILE;
+	for (size_t ty = y / RULE_TILE; ty < ty1 && ty < th; ty++)
+		for (size_t tx = x / RULE_TILE; tx < tx1 && tx < l->rules_w; tx++)
+			l->rules[ty * l->rules_w + tx] = i;
+	landscape_touch(l);
+	return 0;
+}
+
+// Paint a region given as "x,y,w,h,Bx/Sy".
+int landscape_paint_region(struct landscape *l, const char *s)
+{
+	size_t x, y, w, h;
+	uint32_t rule;
+	int n = 0, m;
+
+	if (sscanf(s, "%zu,%zu,%zu,%zu,%n", &x, &y, &w, &h, &n) != 4 || !n
+			|| (m = parse_lifelike_rule(s + n, &rule)) < 0 || s[n + m])
+		return -1;
+	return landscape_paint_rule(l, x, y, w, h, rule);
+}
+
+// Big arrays are only reserved: pages come in as they're touched, so a
+// landscape kept elsewhere (in a mapped file, say) costs nothing here until
+// something draws it.
+static void *landscape_alloc(size_t size)
+{
+	void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return p == MAP_FAILED ? NULL : p;
+}
+
+// Stepping is split into horizontal stripes, one per thread. The pool is
+// started once and then handed jobs of some number of generations. Within a
+// job each thread knows which generation it is on, so the only
+// synchronisation is one barrier at the end of every generation; the
+// landscape itself (show, the engine's buffers) is only updated by the
+// caller once the job is over.
+//
+// Stripes are usually ranges of landscape rows, but an engine may hand out
+// coarser units (rows of tiles, say) by passing its own row count.
+typedef void (*stripe_fn)(struct landscape *, size_t gen, size_t y0, size_t y1);
+
+struct {
+	size_t nthreads;
+	pthread_t *threads;
+	pthread_barrier_t start, gen;
+
+	// the current job
+	struct landscape *landscape;
+	stripe_fn stripe;
+	size_t gens, rows;
+	uint32_t quit:1;
+} pool = { .nthreads = 1 };
+
+static void pool_job(size_t i)
+{
+	// Copy the job out: once past the last barrier the caller is free to
+	// post the next one.
+	struct landscape *l = pool.landscape;
+	stripe_fn stripe = pool.stripe;
+	size_t gens = pool.gens, n = pool.nthreads;
+	size_t y0 = pool.rows * i / n;
+	size_t y1 = pool.rows * (i + 1) / n;
+
+	for (size_t g = 0; g < gens; g++) {
+		stripe(l, g, y0, y1);
+		if (n > 1)
+			pthread_barrier_wait(&pool.gen);
+	}
+}
+
+static void *pool_worker(void *arg)
+{
+	size_t i = (size_t)arg;
+
+	for (;;) {
+		pthread_barrier_wait(&pool.start);
+		if (pool.quit)
+			return NULL;
+		pool_job(i);
+	}
+}
+
+int pool_init(size_t nthreads)
+{
+	if (nthreads == 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	pool.nthreads = nthreads ? nthreads : 1;
+	if (pool.nthreads == 1)
+		return 0;
+
+	pool.threads = calloc(pool.nthreads, sizeof(pthread_t));
+	if (!pool.threads)
+		return -ENOMEM;
+	pthread_barrier_init(&pool.start, NULL, pool.nthreads);
+	pthread_barrier_init(&pool.gen, NULL, pool.nthreads);
+
+	// thread 0 is whoever calls pool_run
+	for (size_t i = 1; i < pool.nthreads; i++)
+		if (pthread_create(&pool.threads[i], NULL, pool_worker, (void *)i))
+			return -1;
+
+	return 0;
+}
+
+void pool_fini(void)
+{
+	if (pool.nthreads < 2)
+		return;
+
+	pool.quit = 1;
+	pthread_barrier_wait(&pool.start);
+	for (size_t i = 1; i < pool.nthreads; i++)
+		pthread_join(pool.threads[i], NULL);
+	pthread_barrier_destroy(&pool.start);
+	pthread_barrier_destroy(&pool.gen);
+	free(pool.threads);
+	pool.nthreads = 1;
+}
+
+// With no generations there'd be no barrier after the start's to hold the
+// caller until the workers had copied the job out.
+void pool_run(struct landscape *l, stripe_fn stripe, size_t gens, size_t rows)
+{
+	if (!gens)
+		return;
+	pool.landscape = l;
+	pool.stripe = stripe;
+	pool.gens = gens;
+	pool.rows = rows;
+
+	if (pool.nthreads > 1)
+		pthread_barrier_wait(&pool.start);
+	pool_job(0);
+}
+
+// Generation `gen` of a job reads one of flip/flop and writes the other,
+// starting from show.
+static void bytes_stripe(struct landscape *l, size_t gen, size_t y0, size_t y1)
+{
+	uint8_t *from = gen & 1 ? landscape_back(l) : l->show;
+	uint8_t *to = gen & 1 ? l->show : landscape_back(l);
+
+	for (size_t y = y0; y < y1; y++)
+		l->automata(l, from, to, y, l->rule);
+	l->quotient(l, to, y0, y1);
+}
+
+// Life-like rules get stripes specialised by kernel and quotient. With both
+// fixed at compile time the row kernel and the halo fill inline into the
+// stripe, and the rule's table is compiled once when the variant is picked
+// instead of for every row. Anything without a variant goes through
+// bytes_stripe and the automata.
+struct {
+	uint32_t rule;
+	void (*quotient)(struct landscape *, uint8_t *, size_t, size_t);
+	life_row_fn row;
+	stripe_fn stripe;
+	struct life_lut lut;
+} life;
+
+#define LIFE_STRIPE(kernel, quot, ...)						\
+__VA_ARGS__ static void life_stripe_##kernel##_##quot(struct landscape *l,	\
+		size_t gen, size_t y0, size_t y1)				\
+{										\
+	uint8_t *from = gen & 1 ? landscape_back(l) : l->show;			\
+	uint8_t *to = gen & 1 ? l->show : landscape_back(l);			\
+										\
+	for (size_t y = y0; y < y1; y++) {					\
+		const uint8_t *c = landscape_row(l, from, y);			\
+		life_row_##kernel(landscape_row(l, to, y), c - l->stride, c,	\
+				c + l->stride, l->width, &life.lut, NULL);	\
+	}									\
+	quot(l, to, y0, y1);							\
+}
+
+LIFE_STRIPE(scalar, quotient_torus)
+LIFE_STRIPE(scalar, clamped)
+#if defined(__x86_64__) || defined(__i386__)
+LIFE_STRIPE(ssse3, quotient_torus, __attribute__((target("ssse3"))))
+LIFE_STRIPE(ssse3, clamped, __attribute__((target("ssse3"))))
+LIFE_STRIPE(avx2, quotient_torus, __attribute__((target("avx2"))))
+LIFE_STRIPE(avx2, clamped, __attribute__((target("avx2"))))
+#endif
+
+#define LIFE_VARIANT(kernel, quot) \
+	{ life_row_##kernel, quot, life_stripe_##kernel##_##quot }
+
+static const struct life_variant {
+	life_row_fn row;
+	void (*quotient)(struct landscape *, uint8_t *, size_t, size_t);
+	stripe_fn stripe;
+} life_variants[] = {
+	LIFE_VARIANT(scalar, quotient_torus),
+	LIFE_VARIANT(scalar, clamped),
+#if defined(__x86_64__) || defined(__i386__)
+	LIFE_VARIANT(ssse3, quotient_torus),
+	LIFE_VARIANT(ssse3, clamped),
+	LIFE_VARIANT(avx2, quotient_torus),
+	LIFE_VARIANT(avx2, clamped),
+#endif
+};
+
+// Cells [x0, x1) of row y, a run of tiles with the same rule at a time, so
+// the kernel still sees long rows; x0 is on a LIFE_CHUNK. Once any rule has
+// more than two states every tile takes gens_row, which counts a dying
+// neighbour across the border as the dead cell it is.
+static void rules_row(struct landscape *l, const struct life_lut *luts,
+		const uint8_t *from, uint8_t *to, size_t x0, size_t x1, size_t y,
+		uint8_t *changed)
+{
+	life_row_fn row = l->states > 2 ? gens_row : life_row;
+
+	const uint8_t *map = &l->rules[y / RULE_TILE * l->rules_w];
+
+	for (size_t a = x0, b; a < x1; a = b) {
+		uint8_t i = map[a / RULE_TILE];
+		for (b = (a / RULE_TILE + 1) * RULE_TILE;
+				b < x1 && map[b / RULE_TILE] == i; b += RULE_TILE)
+			;
+		b = b < x1 ? b : x1;
+
+		const uint8_t *c = landscape_at(l, (uint8_t *)from, a, y);
+		row(landscape_at(l, to, a, y), c - l->stride, c,
+				c + l->stride, b - a, &luts[i],
+				changed ? changed + (a - x0) / LIFE_CHUNK : NULL);
 	}
+}
+
+static void rules_compile(struct landscape *l, struct life_lut *luts)
+{
+	for (int i = 0; i < RULES_MAX; i++)
+		life_lut_compile(landscape_rule(l, i), &luts[i]);
+}
+
+static void rules_stripe(struct landscape *l, size_t gen, size_t y0, size_t y1)
+{
+	uint8_t *from = gen & 1 ? landscape_back(l) : l->show;
+	uint8_t *to = gen & 1 ? l->show : landscape_back(l);
+	struct life_lut luts[RULES_MAX];
+
+	rules_compile(l, luts);
+	for (size_t y = y0; y < y1; y++)
+		rules_row(l, luts, from, to, 0, l->width, y, NULL);
+	l->quotient(l, to, y0, y1);
+}
+
+// Stochastic life-like steps: the rule's row, then the cells whose coins
+// came up tails put back.
+static void noise_stripe(struct landscape *l, size_t gen, size_t y0, size_t y1)
+{
+	uint8_t *from = gen & 1 ? landscape_back(l) : l->show;
+	uint8_t *to = gen & 1 ? l->show : landscape_back(l);
+	struct life_lut luts[RULES_MAX];
+
+	if (l->rules)
+		rules_compile(l, luts);
+	else
+		life_lut_compile(l->rule, &luts[0]);
+	for (size_t y = y0; y < y1; y++) {
+		const uint8_t *c = landscape_row(l, from, y);
+		if (l->rules)
+			rules_row(l, luts, from, to, 0, l->width, y, NULL);
+		else
+			(luts[0].states > 2 ? gens_row : life_row)(
+					landscape_row(l, to, y), c - l->stride,
+					c, c + l->stride, l->width, &luts[0],
+					NULL);
+		noise_keep_cells(l, l->generation + gen, y, c,
+				landscape_row(l, to, y), l->width);
+	}
+	l->quotient(l, to, y0, y1);
+}
+
+// Generations rules step through the kernel pointer, the row being long
+// enough that the call doesn't show.
+static void gens_stripe(struct landscape *l, size_t gen, size_t y0, size_t y1)
+{
+	uint8_t *from = gen & 1 ? landscape_back(l) : l->show;
+	uint8_t *to = gen & 1 ? l->show : landscape_back(l);
+	struct life_lut lut;
+
+	life_lut_compile(l->rule, &lut);
+	for (size_t y = y0; y < y1; y++) {
+		const uint8_t *c = landscape_row(l, from, y);
+		gens_row(landscape_row(l, to, y), c - l->stride, c,
+				c + l->stride, l->width, &lut, NULL);
+	}
+	l->quotient(l, to, y0, y1);
+}
+
+// Larger than Life counts each cell's neighbourhood by sliding it, so a step
+// costs the same per cell whatever the range. Rows past the landscape's
+// edges, and the columns either side, are the cells the quotient folds them
+// onto. ltl_alive lays out row y's living, 1 or 0, with pad more each side.
+static void ltl_alive(struct landscape *l, const uint8_t *from, long y,
+		size_t pad, uint8_t *a)
+{
+	size_t X, Y, w = l->width;
+	const uint8_t *row;
+
+	landscape_fold(l, 0, y, &X, &Y);
+	row = landscape_row(l, (uint8_t *)from, Y);
+	for (size_t x = 0; x < w; x++)
+		a[pad + x] = row[x] == 1;
+	for (size_t j = 0; j < pad; j++) {
+		landscape_fold(l, (int)j - (int)pad, Y, &X, &Y);
+		a[j] = row[X] == 1;
+		landscape_fold(l, w + j, Y, &X, &Y);
+		a[pad + w + j] = row[X] == 1;
+	}
+}
+
+static const uint8_t *ltl_row(struct landscape *l, const uint8_t *from, long y)
+{
+	size_t X, Y;
+
+	landscape_fold(l, 0, y, &X, &Y);
+	return landscape_row(l, (uint8_t *)from, Y);
+}
+
+// Moore: a sum down each padded column over rows y-R..y+R, moved down a row
+// at a time, then a prefix sum along the row, one subtraction a cell.
+static int ltl_square(struct landscape *l, const uint8_t *from, uint8_t *to,
+		size_t gen, size_t y0, size_t y1)
+{
+	long R = l->ltl.range, y;
+	size_t w = l->width, pw = w + 2 * R, X, Y;
+	uint16_t *col = calloc(2 * pw + 1 + w, sizeof(uint16_t));
+	uint8_t *a = malloc(pw);
+	uint16_t *pre = col + pw, *n = pre + pw + 1;
+
+	if (!col || !a) {
+		free(col), free(a);
+		return -ENOMEM;
+	}
+
+	for (y = (long)y0 - R; y <= (long)y0 + R; y++) {
+		ltl_alive(l, from, y, R, a);
+		for (size_t j = 0; j < pw; j++)
+			col[j] += a[j];
+	}
+	for (y = y0; ; y++) {
+		const uint8_t *c = landscape_row(l, (uint8_t *)from, y);
+		uint8_t *out = landscape_row(l, to, y);
+
+		pre[0] = 0;
+		for (size_t j = 0; j < pw; j++)
+			pre[j + 1] = pre[j] + col[j];
+		ltl_kernel->diff(n, pre + 2 * R + 1, pre, w);
+		ltl_kernel->next(out, c, n, w, &l->ltl);
+		if (l->alpha < 256)
+			noise_keep_cells(l, l->generation + gen, y, c, out, w);
+		if (y + 1 == (long)y1)
+			break;
+
+		// row y + R + 1 in, row y - R out
+		const uint8_t *in = ltl_row(l, from, y + R + 1);
+		const uint8_t *gone = ltl_row(l, from, y - R);
+		ltl_kernel->slide(col + R, in, gone, w);
+		for (long j = 0; j < R; j++) {
+			landscape_fold(l, j - R, 0, &X, &Y);
+			col[j] += (in[X] == 1) - (gone[X] == 1);
+			landscape_fold(l, w + j, 0, &X, &Y);
+			col[R + w + j] += (in[X] == 1) - (gone[X] == 1);
+		}
+	}
+
+	free(col), free(a);
+	return 0;
+}
+
+// Row y's living and diagonal sums, a, dr and dl, padded P each side and
+// running on from row y - 1's, dr1 and dl1; NULL to start them.
+static void ltl_diagonals(struct landscape *l, const uint8_t *from, long y,
+		long P, uint8_t *a, uint16_t *dr, uint16_t *dl,
+		const uint16_t *dr1, const uint16_t *dl1)
+{
+	size_t w = l->width, pw = w + 2 * P, X, Y;
+	const uint8_t *row = ltl_row(l, from, y);
+
+	if (!dr1) {
+		ltl_alive(l, from, y, P, a);
+		for (size_t j = 0; j < pw; j++)
+			dr[j] = dl[j] = a[j];
+		return;
+	}
+	ltl_kernel->diagonals(a + P, dr + P, dl + P, row, dr1 + P, dl1 + P, w);
+	for (long j = 0; j < P; j++) {
+		size_t k = P + w + j;
+
+		landscape_fold(l, j - P, 0, &X, &Y);
+		a[j] = row[X] == 1;
+		dr[j] = a[j] + (j ? dr1[j - 1] : 0);
+		dl[j] = a[j] + dl1[j + 1];
+		landscape_fold(l, w + j, 0, &X, &Y);
+		a[k] = row[X] == 1;
+		dr[k] = a[k] + dr1[k - 1];
+		dl[k] = a[k] + (k + 1 < pw ? dl1[k + 1] : 0);
+	}
+}
+
+// von Neumann: the diamond is slid down a row at a time. Going from c to c+1
+// it gains its lower two edges and loses its upper two, each a run along a
+// diagonal, so with prefix sums down the diagonals (dr running down and
+// right, dl down and left) each edge is a subtraction. The diagonals are
+// kept in a ring of the 2R+3 rows in play, padded R+1 columns either side.
+static int ltl_diamond(struct landscape *l, const uint8_t *from, uint8_t *to,
+		size_t gen, size_t y0, size_t y1)
+{
+	long R = l->ltl.range, P = R + 1, K = 2 * R + 3, y;
+	long top = (long)y0 - R - 1; // the ring's first row
+	size_t w = l->width, pw = w + 2 * P;
+	uint16_t *dr = malloc((2 * K * pw + pw + 1 + w) * sizeof(uint16_t));
+	uint8_t *alive = malloc(K * pw);
+	uint16_t *dl = dr + K * pw, *pre = dl + K * pw, *n = pre + pw + 1;
+
+	if (!dr || !alive) {
+		free(dr), free(alive);
+		return -ENOMEM;
+	}
+#define ring(r) (((r) - top) % K * (long)pw)
+
+	// the first row's counts a run of the diamond's rows at a time
+	memset(n, 0, w * sizeof(uint16_t));
+	for (long dy = -R; dy <= R; dy++) {
+		long h = R - labs(dy);
+
+		ltl_alive(l, from, (long)y0 + dy, P, alive);
+		pre[0] = 0;
+		for (size_t j = 0; j < pw; j++)
+			pre[j + 1] = pre[j] + alive[j];
+		for (size_t x = 0; x < w; x++)
+			n[x] += pre[x + P + h + 1] - pre[x + P - h];
+	}
+
+	for (y = top; ; y++) {
+		uint8_t *a = &alive[ring(y)];
+		uint16_t *r = &dr[ring(y)], *f = &dl[ring(y)];
+
+		ltl_diagonals(l, from, y, P, a, r, f,
+				y == top ? NULL : &dr[ring(y - 1)],
+				y == top ? NULL : &dl[ring(y - 1)]);
+		if (y <= (long)y0 + R)
+			continue;
+
+		// which is as far down as row c's diamond reaches
+		long c = y - R - 1;
+		const uint8_t *cells = landscape_row(l, (uint8_t *)from, c);
+		uint8_t *out = landscape_row(l, to, c);
+		ltl_kernel->next(out, cells, n, w, &l->ltl);
+		if (l->alpha < 256)
+			noise_keep_cells(l, l->generation + gen, c, cells, out, w);
+		if (c + 1 == (long)y1)
+			break;
+
+		// then the diamond steps down to c + 1, gaining along the
+		// diagonals to row y and losing along those to row c
+		const uint16_t *r0 = &dr[ring(c)], *f0 = &dl[ring(c)];
+		const uint16_t *rt = &dr[ring(c - R - 1)];
+		const uint16_t *ft = &dl[ring(c - R - 1)];
+		const uint16_t *gain[4] = { r + P, f + P, rt + P - 1, ft + P + 1 };
+		const uint16_t *loss[4] = { r0 + P - R - 1, f0 + P + R + 1,
+			r0 + P + R, f0 + P - R };
+		ltl_kernel->diamond(n, gain, &alive[ring(c - R)] + P, loss,
+				a + P, w);
+	}
+#undef ring
+	free(dr), free(alive);
+	return 0;
+}
+
+static int ltl_rows(struct landscape *l, const uint8_t *from, uint8_t *to,
+		size_t gen, size_t y0, size_t y1)
+{
+	return (l->ltl.shape == ltl_moore ? ltl_square : ltl_diamond)(l, from,
+			to, gen, y0, y1);
+}
+
+// Starting the sums costs O(R) a column, once a stripe; after that a cell
+// costs the same whatever the range. Without the memory for the sums the
+// stripe's cells stand still.
+static void ltl_stripe(struct landscape *l, size_t gen, size_t y0, size_t y1)
+{
+	uint8_t *from = gen & 1 ? landscape_back(l) : l->show;
+	uint8_t *to = gen & 1 ? l->show : landscape_back(l);
+
+	if (ltl_rows(l, from, to, gen, y0, y1) < 0) {
+		fprintf(stderr, "no mem to step rows %zu..%zu\n", y0, y1);
+		for (size_t y = y0; y < y1; y++)
+			memcpy(landscape_row(l, to, y),
+					landscape_row(l, from, y), l->width);
+	}
+	l->quotient(l, to, y0, y1);
+}
+
+// The automata for a lone row, which pays the stripe's start for it. Only
+// ltl_stripe steps whole landscapes.
+void twod_larger(struct landscape *l, const uint8_t *from, uint8_t *to,
+		size_t y, uint32_t rule)
+{
+	(void)rule;
+	if (ltl_rows(l, from, to, 0, y, y + 1) < 0)
+		memcpy(landscape_row(l, to, y),
+				landscape_row(l, (uint8_t *)from, y), l->width);
+}
+
+// The stripe for l's automata, rule, quotient and kernel; looked up again
+// only when one of them changes.
+static stripe_fn bytes_specialise(struct landscape *l)
+{
+	if (l->automata == twod_larger)
+		return ltl_stripe;
+	if (l->automata != twod_life_like)
+		return bytes_stripe;
+	if (l->alpha < 256)
+		return noise_stripe;
+	if (l->rules)
+		return rules_stripe;
+	if (l->states > 2)
+		return gens_stripe;
+
+	if (life.stripe && life.rule == l->rule && life.quotient == l->quotient
+			&& life.row == life_row)
+		return life.stripe;
+
+	life.rule = l->rule;
+	life.quotient = l->quotient;
+	life.row = life_row;
+	life.stripe = bytes_stripe;
+	life_lut_compile(l->rule, &life.lut);
+	for (size_t i = 0; i < sizeof(life_variants)/sizeof(*life_variants); i++)
+		if (life_variants[i].row == life_row
+				&& life_variants[i].quotient == l->quotient)
+			life.stripe = life_variants[i].stripe;
+
+	return life.stripe;
+}
+
+void landscape_advance_bytes(struct landscape *l, size_t gens)
+{
+	// show may have been painted since the last step
+	l->quotient(l, l->show, 0, l->height);
+	pool_run(l, bytes_specialise(l), gens, l->height);
+
+	if (gens & 1)
+		l->show = landscape_back(l);
+}
+
+// The most states of any rule in play. Palette slots no tile uses may count
+// too, which costs the Generations kernel but changes nothing.
+static uint32_t landscape_states(struct landscape *l)
+{
+	uint32_t s = l->automata == twod_life_like ? rule_states(l->rule)
+		: l->automata == twod_larger ? l->ltl.states : 2;
+
+	for (int i = 1; l->rules && i < RULES_MAX; i++)
+		if (rule_states(l->palette[i]) > s)
+			s = rule_states(l->palette[i]);
+	return s;
+}
+
+// The rules in play went from l->states to s. Cells at or past the new last
+// state die, and the engine's copy is rebuilt in its new shape.
+static void landscape_restate(struct landscape *l, uint32_t s)
+{
+	landscape_sync(l);
+	for (size_t y = 0; y < l->height && s < l->states; y++) {
+		uint8_t *row = landscape_row(l, l->show, y);
+		for (size_t x = 0; x < l->width; x++)
+			row[x] = row[x] < s ? row[x] : 0;
+	}
+	l->states = s;
+	landscape_touch(l);
+}
+
+void landscape_advance(struct landscape *l, size_t gens)
+{
+	const struct engine *e = landscape_engine(l);
+	uint32_t s = landscape_states(l);
+
+	// 0 is as good as 2, for landscapes set up before states were
+	if (s != l->states && (s > 2 || l->states > 2))
+		landscape_restate(l, s);
+
+	if (l->engine_stale && e->pack)
+		e->pack(l);
+	l->engine_stale = 0;
+
+	e->advance(l, gens);
+	l->generation += gens;
+}
+
+void landscape_step(struct landscape *l)
+{
+	landscape_advance(l, 1);
+}
+
+// The packed engine: 64 cells to a uint64_t, bit b of word i is the cell at
+// x = 64*i + b. Neighbour counts are done with bit-sliced adders, so one pass
+// over a word updates all of its cells at once.
+//
+// The planes of ages a Generations rule needs: its dying are 2..states - 1,
+// ages 1..states - 2. They're only reserved, so a rule with fewer states,
+// or none, costs nothing for the planes it leaves alone.
+#define STATES_PLANES 4
+#define states_planes(c) ((c) > 2 ? 32 - __builtin_clz((c) - 2) : 0)
+
+int packed_init(struct landscape *l)
+{
+	l->words = (l->width + 63) / 64;
+	size_t plane = l->words * l->height * sizeof(uint64_t);
+
+	l->packed = calloc(l->words * l->height, sizeof(uint64_t));
+	l->packed_next = calloc(l->words * l->height, sizeof(uint64_t));
+	l->dying = landscape_alloc(STATES_PLANES * plane);
+	l->dying_next = landscape_alloc(STATES_PLANES * plane);
+	if (!(l->packed && l->packed_next && l->dying && l->dying_next))
+		return -ENOMEM;
+
+	return 0;
+}
+
+// Row y of age plane j.
+static inline uint64_t *packed_dying(struct landscape *l, uint64_t *planes,
+		size_t j, size_t y)
+{
+	return &planes[(j * l->height + y) * l->words];
+}
+
+static inline uint64_t packed_cell(const uint64_t *row, size_t x)
+{
+	return row[x >> 6] >> (x & 63) & 1;
+}
+
+// The state of cell (x, y), from the living and the ages.
+static inline uint8_t packed_state(struct landscape *l, size_t x, size_t y)
+{
+	uint8_t age = 0;
+
+	if (packed_cell(&l->packed[y * l->words], x))
+		return 1;
+	for (int j = 0; j < states_planes(l->states); j++)
+		age |= packed_cell(packed_dying(l, l->dying, j, y), x) << j;
+	return age ? age + 1 : 0;
+}
+
+void packed_pack(struct landscape *l)
+{
+	int d = states_planes(l->states);
+
+	for (size_t y = 0; y < l->height; y++) {
+		uint64_t *row = &l->packed[y * l->words];
+		uint8_t *cells = landscape_row(l, l->show, y);
+
+		memset(row, 0, l->words * sizeof(uint64_t));
+		for (size_t x = 0; x < l->width; x++)
+			row[x >> 6] |= (uint64_t)(cells[x] == 1) << (x & 63);
+
+		for (int j = 0; j < d; j++) {
+			uint64_t *age = packed_dying(l, l->dying, j, y);
+			memset(age, 0, l->words * sizeof(uint64_t));
+			for (size_t x = 0; x < l->width; x++)
+				age[x >> 6] |= (uint64_t)(cells[x] > 1
+					&& (cells[x] - 1) >> j & 1) << (x & 63);
+		}
+	}
+}
+
+void packed_unpack(struct landscape *l)
+{
+	for (size_t y = 0; y < l->height; y++) {
+		uint64_t *row = &l->packed[y * l->words];
+		uint8_t *cells = landscape_row(l, l->show, y);
+
+		if (l->states > 2) {
+			for (size_t x = 0; x < l->width; x++)
+				cells[x] = packed_state(l, x, y);
+			continue;
+		}
+		for (size_t x = 0; x < l->width; x++)
+			cells[x] = row[x >> 6] >> (x & 63) & 1;
+	}
+}
+
+// Wipe the ages, for something writing the living straight into the packed
+// rows.
+static void packed_clear_dying(struct landscape *l)
+{
+	for (int j = 0; j < states_planes(l->states); j++)
+		memset(packed_dying(l, l->dying, j, 0), 0,
+				l->words * l->height * sizeof(uint64_t));
+}
+
+// Horizontal sum (west + self + east) of word i as a 2-bit number, bit-sliced
+// into s0 and s1. `west` and `east` are the cells just off either end of the
+// row, as the quotient sees them.
+static inline void packed_add3(uint64_t w, uint64_t c, uint64_t e,
+		uint64_t *s0, uint64_t *s1)
+{
+	*s0 = w ^ c ^ e;
+	*s1 = (w & c) | (e & (w ^ c));
+}
+
+static inline void packed_sum3(const uint64_t *row, size_t i, size_t words,
+		size_t tail, uint64_t west, uint64_t east,
+		uint64_t *s0, uint64_t *s1)
+{
+	uint64_t c = row[i];
+	uint64_t w = c << 1 | (i ? row[i - 1] >> 63 : west);
+	uint64_t e = c >> 1 | (i + 1 < words ? row[i + 1] << 63 : east << (tail - 1));
+
+	packed_add3(w, c, e, s0, s1);
+}
+
+// The 3x3 block sum, self included, runs 0..9. A dead cell with block sum k
+// has k live neighbours, a live one has k - 1, so the rule folds into two
+// masks per k.
+struct packed_rule {
+	uint64_t born[10], keep[10];
+	uint32_t states;
+};
+
+static void packed_rule_compile(uint32_t rule, struct packed_rule *pr)
+{
+	for (int k = 0; k < 10; k++) {
+		pr->born[k] = k < 9 && (rule & birth_bit(k)) ? ~(uint64_t)0 : 0;
+		pr->keep[k] = k > 0 && (rule & survive_bit(k - 1)) ? ~(uint64_t)0 : 0;
+	}
+	pr->states = rule_states(rule);
+}
+
+// Next state of a word, from the horizontal sums of the rows above (a), at
+// (b) and below (c).
+static inline uint64_t packed_rule_apply(const struct packed_rule *pr,
+		uint64_t a0, uint64_t a1, uint64_t b0, uint64_t b1,
+		uint64_t c0, uint64_t c1, uint64_t alive)
+{
+	// ones column: full adder, carry into the twos
+	uint64_t t0 = a0 ^ b0 ^ c0;
+	uint64_t k = (a0 & b0) | (c0 & (a0 ^ b0));
+	// twos column: a1 + b1 + c1 + k
+	uint64_t x0 = a1 ^ b1 ^ c1;
+	uint64_t x1 = (a1 & b1) | (c1 & (a1 ^ b1));
+	uint64_t t1 = x0 ^ k;
+	uint64_t y1 = x0 & k;
+	uint64_t t2 = x1 ^ y1;
+	uint64_t t3 = x1 & y1;
+
+	uint64_t next = 0;
+	for (int n = 0; n < 10; n++) {
+		if (!(pr->born[n] | pr->keep[n]))
+			continue;
+		uint64_t eq = ~((t0 ^ -(uint64_t)(n & 1))
+			| (t1 ^ -(uint64_t)(n >> 1 & 1))
+			| (t2 ^ -(uint64_t)(n >> 2 & 1))
+			| (t3 ^ -(uint64_t)(n >> 3 & 1)));
+		next |= eq & ((pr->born[n] & ~alive) | (pr->keep[n] & alive));
+	}
+	return next;
+}
+
+// The ages of a word under a Generations rule, d planes of them: the dying
+// age by one, going back to dead on reaching states - 1, and the living that
+// didn't survive start at 1. Returns next with the dying kept from being
+// born. A rule with fewer states than the planes allow (a tile of plain
+// Life beside one of Generations, say) ends its dying in a generation.
+static inline uint64_t packed_rule_age(const struct packed_rule *pr, int d,
+		const uint64_t *from, uint64_t *to, size_t stride,
+		uint64_t alive, uint64_t next)
+{
+	uint64_t a[STATES_PLANES], dying = 0, carry = ~(uint64_t)0;
+	uint32_t last = pr->states - 1;
+
+	for (int j = 0; j < d; j++) {
+		a[j] = from[j * stride];
+		dying |= a[j];
+	}
+	// add one, a ripple carry; what carries out of the top has reached
+	// 2^d, which is past or at last
+	for (int j = 0; j < d; j++) {
+		uint64_t t = a[j];
+		a[j] ^= carry;
+		carry &= t;
+	}
+	// a >= last, from the top bit down
+	uint64_t gt = 0, eq = ~(uint64_t)0;
+	for (int j = d - 1; j >= 0; j--) {
+		if (last >> j & 1) {
+			eq &= a[j];
+		} else {
+			gt |= eq & a[j];
+			eq &= ~a[j];
+		}
+	}
+	uint64_t done = carry | (last >> d ? 0 : gt | eq);
+	uint64_t keep = dying & ~done;
+	uint64_t start = pr->states > 2 ? alive & ~next : 0;
+
+	to[0] = (a[0] & keep) | start;
+	for (int j = 1; j < d; j++)
+		to[j * stride] = a[j] & keep;
+	return next & ~dying;
+}
+
+static void packed_stripe(struct landscape *l, size_t gen, size_t y0, size_t y1)
+{
+	const uint64_t *from = gen & 1 ? l->packed_next : l->packed;
+	uint64_t *to = gen & 1 ? l->packed : l->packed_next;
+	uint64_t *aged = gen & 1 ? l->dying_next : l->dying;
+	uint64_t *ages = gen & 1 ? l->dying : l->dying_next;
+	size_t plane = l->words * l->height;
+	int d = states_planes(l->states);
+
+	// compiling per stripe is cheaper than sharing it between threads
+	struct packed_rule pr[RULES_MAX];
+	for (int i = 0; i < (l->rules ? RULES_MAX : 1); i++)
+		packed_rule_compile(landscape_rule(l, i), &pr[i]);
+
+	size_t words = l->words, tail = l->width - 64 * (words - 1);
+	uint64_t last = tail == 64 ? ~(uint64_t)0 : ((uint64_t)1 << tail) - 1;
+	int torus = l->quotient == quotient_torus;
+
+	for (size_t y = y0; y < y1; y++) {
+		const uint64_t *rows[3];
+		uint64_t west[3], east[3];
+
+		if (torus) {
+			rows[0] = &from[(y ? y - 1 : l->height - 1) * words];
+			rows[2] = &from[(y + 1 < l->height ? y + 1 : 0) * words];
+		} else {
+			rows[0] = &from[(y ? y - 1 : 0) * words];
+			rows[2] = &from[(y + 1 < l->height ? y + 1 : y) * words];
+		}
+		rows[1] = &from[y * words];
+
+		for (int r = 0; r < 3; r++) {
+			west[r] = packed_cell(rows[r], torus ? l->width - 1 : 0);
+			east[r] = packed_cell(rows[r], torus ? 0 : l->width - 1);
+		}
+
+		// a word is a rule tile wide; runs of words under one rule go
+		// together
+		const uint8_t *map = l->rules ? &l->rules[y / RULE_TILE * words] : NULL;
+		uint64_t *out = &to[y * words];
+		for (size_t i = 0, j = words; i < words; i = j) {
+			const struct packed_rule *p = &pr[map ? map[i] : 0];
+			for (j = i + 1; map && j < words && map[j] == map[i]; j++)
+				;
+			if (!map)
+				j = words;
+
+			for (size_t k = i; k < j; k++) {
+				uint64_t a0, a1, b0, b1, c0, c1;
+				packed_sum3(rows[0], k, words, tail, west[0], east[0], &a0, &a1);
+				packed_sum3(rows[1], k, words, tail, west[1], east[1], &b0, &b1);
+				packed_sum3(rows[2], k, words, tail, west[2], east[2], &c0, &c1);
+
+				out[k] = packed_rule_apply(p, a0, a1, b0, b1,
+						c0, c1, rows[1][k]);
+				if (d)
+					out[k] = packed_rule_age(p, d,
+						&aged[y * words + k],
+						&ages[y * words + k], plane,
+						rows[1][k], out[k]);
+			}
+		}
+		if (l->alpha < 256)
+			noise_keep_words(l, l->generation + gen, y, rows[1],
+					out, words);
+		out[words - 1] &= last;
+	}
+}
+
+void packed_advance(struct landscape *l, size_t gens)
+{
+	if (l->automata != twod_life_like || (l->states > 2 && l->alpha < 256)) {
+		// Only life-like rules have a packed kernel, and the coins
+		// only put back the living.
+		landscape_sync(l);
+		landscape_advance_bytes(l, gens);
+		l->engine_stale = 1;
+		return;
+	}
+
+	pool_run(l, packed_stripe, gens, l->height);
+
+	if (gens & 1) {
+		uint64_t *tmp = l->packed;
+		l->packed = l->packed_next;
+		l->packed_next = tmp;
+		tmp = l->dying;
+		l->dying = l->dying_next;
+		l->dying_next = tmp;
+	}
+	l->show_stale = 1;
+}
+
+// The mapped engine keeps the packed engine's rows in a file, which is both
+// the working store and a snapshot: opening an existing one resumes it, no
+// parsing involved. After a page of header the file holds two planes of
+// packed rows, one per generation parity, each page aligned. Stepping
+// streams through bands of rows, asking the kernel to read ahead of each
+// band and to drop what's behind it, so only a few bands per thread need
+// be resident however big the landscape.
+#define MAPPED_MAGIC "CLSNAP1\n"
+#define MAPPED_BAND 64 // [rows]
+
+struct mapped_header {
+	char magic[8];
+	uint64_t width, height, words;
+	uint64_t rule, torus;
+	uint64_t generation;
+	uint64_t cur; // the plane holding the current generation
+};
+
+struct {
+	struct mapped_header *header;
+	uint64_t *planes[2];
+	size_t plane_size, page;
+	int refused; // said so once already
+} mapped;
+
+// The file holds the living and a life-like rule only, so the dying of a
+// Generations rule, or a Larger than Life rule, would have to step in show
+// and leave the map behind.
+int mapped_holds(struct landscape *l)
+{
+	return l->automata == twod_life_like && landscape_states(l) == 2;
+}
+
+int mapped_init(struct landscape *l)
+{
+	struct stat st;
+	int fd;
+
+	if (!l->store) {
+		fprintf(stderr, "the mapped engine needs a file: -m path\n");
+		return -1;
+	}
+
+	fd = open(l->store, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		fprintf(stderr, "%s: %s\n", l->store, strerror(errno));
+		return -1;
+	}
+
+	struct mapped_header h;
+	int resume = st.st_size > 0;
+	if (resume) {
+		if (pread(fd, &h, sizeof(h), 0) != sizeof(h)
+				|| memcmp(h.magic, MAPPED_MAGIC, 8)) {
+			fprintf(stderr, "%s: not a landscape\n", l->store);
+			close(fd);
+			return -1;
+		}
+		l->width = h.width;
+		l->height = h.height;
+		l->rule = h.rule;
+		l->automata = twod_life_like;
+		l->quotient = h.torus ? quotient_torus : clamped;
+		// the noise's counter carries on where it left off
+		l->generation = h.generation;
+	}
+	if (!mapped_holds(l)) {
+		fprintf(stderr, "%s: the map holds two state rules only\n",
+				l->store);
+		if (!resume)
+			unlink(l->store);
+		close(fd);
+		return -1;
+	}
+
+	mapped.page = sysconf(_SC_PAGESIZE);
+	l->words = (l->width + 63) / 64;
+	mapped.plane_size = l->words * l->height * sizeof(uint64_t);
+	mapped.plane_size = (mapped.plane_size + mapped.page - 1) & ~(mapped.page - 1);
+	size_t size = mapped.page + 2 * mapped.plane_size;
+
+	if (!resume && ftruncate(fd, size) < 0) {
+		fprintf(stderr, "%s: %s\n", l->store, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	if (resume && (uint64_t)st.st_size < size) {
+		fprintf(stderr, "%s: truncated\n", l->store);
+		close(fd);
+		return -1;
+	}
+
+	void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "%s: %s\n", l->store, strerror(errno));
+		return -1;
+	}
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	mapped.header = data;
+	mapped.planes[0] = (uint64_t *)((char *)data + mapped.page);
+	mapped.planes[1] = (uint64_t *)((char *)data + mapped.page + mapped.plane_size);
+	if (!resume) {
+		memcpy(mapped.header->magic, MAPPED_MAGIC, 8);
+		mapped.header->width = l->width;
+		mapped.header->height = l->height;
+		mapped.header->words = l->words;
+		mapped.header->rule = l->rule;
+		mapped.header->torus = l->quotient == quotient_torus;
+		mapped.header->generation = l->generation;
+	}
+
+	l->packed = mapped.planes[mapped.header->cur & 1];
+	l->packed_next = mapped.planes[!(mapped.header->cur & 1)];
+	// the file is the truth until show is painted
+	l->show_stale = 1;
+	// never holding ages, but the packed paths want somewhere to clear
+	l->dying = landscape_alloc(STATES_PLANES * mapped.plane_size);
+	l->dying_next = landscape_alloc(STATES_PLANES * mapped.plane_size);
+	if (!(l->dying && l->dying_next))
+		return -ENOMEM;
+
+	return 0;
+}
+
+// Advise on rows [y0, y1) of a plane. Read ahead is rounded out to whole
+// pages; dropping is rounded in, so it never touches a row outside.
+static void mapped_advise(struct landscape *l, const uint64_t *plane,
+		long y0, long y1, int advice)
+{
+	size_t row = l->words * sizeof(uint64_t), page = mapped.page;
+	uintptr_t a, b;
+
+	y0 = y0 < 0 ? 0 : y0;
+	y1 = y1 > (long)l->height ? (long)l->height : y1;
+	if (y0 >= y1)
+		return;
+
+	a = (uintptr_t)plane + y0 * row;
+	b = (uintptr_t)plane + y1 * row;
+	if (advice == MADV_WILLNEED) {
+		a &= ~(page - 1);
+		b = (b + page - 1) & ~(page - 1);
+	} else {
+		a = (a + page - 1) & ~(page - 1);
+		b &= ~(page - 1);
+	}
+	if (a < b)
+		madvise((void *)a, b - a, advice);
+}
+
+static void mapped_stripe(struct landscape *l, size_t gen, size_t y0, size_t y1)
+{
+	const uint64_t *from = gen & 1 ? l->packed_next : l->packed;
+	const uint64_t *to = gen & 1 ? l->packed : l->packed_next;
+
+	for (size_t b0 = y0; b0 < y1; b0 += MAPPED_BAND) {
+		size_t b1 = b0 + MAPPED_BAND < y1 ? b0 + MAPPED_BAND : y1;
+
+		mapped_advise(l, from, b1, b1 + MAPPED_BAND + 1, MADV_WILLNEED);
+		packed_stripe(l, gen, b0, b1);
+		// the next band still wants this one's last row
+		mapped_advise(l, from, (long)b0 - 1, (long)b1 - 1, MADV_DONTNEED);
+		mapped_advise(l, to, b0, b1, MADV_DONTNEED);
+	}
+}
+
+void mapped_advance(struct landscape *l, size_t gens)
+{
+	// a rule from a pattern or the keyboard, too late for mapped_init
+	if (!mapped_holds(l)) {
+		if (!mapped.refused)
+			fprintf(stderr, "%s can't hold this rule; not stepping\n",
+					l->store);
+		mapped.refused = 1;
+		return;
+	}
+	mapped.refused = 0;
+
+	pool_run(l, mapped_stripe, gens, l->height);
+
+	if (gens & 1) {
+		uint64_t *tmp = l->packed;
+		l->packed = l->packed_next;
+		l->packed_next = tmp;
+	}
+	l->show_stale = 1;
+
+	mapped.header->cur = l->packed == mapped.planes[1];
+	mapped.header->generation += gens;
+	mapped.header->rule = l->rule;
+	mapped.header->torus = l->quotient == quotient_torus;
+	msync(mapped.header, mapped.page, MS_ASYNC);
+}
+
+// HashLife: the landscape is a window on an unbounded plane held as a
+// quadtree. Identical subtrees are shared (hash-consed), and each node
+// remembers what its centre becomes some power of two generations later,
+// so repeated structure and empty space cost nothing to step. The quotient
+// doesn't apply here; nothing wraps or clamps.
+//
+// A node of level L is a 2^L square. Level 0 nodes are single cells.
+struct hl_node {
+	struct hl_node *nw, *ne, *sw, *se;
+	struct hl_node *next;   // hash chain, or free list
+	struct hl_node *result; // centre after 2^(level-2) generations
+	struct hl_node *slow;   // centre after 2^slow_j generations
+	uint64_t pop;
+	uint32_t level, slow_j, mark;
+};
+
+#define HL_SLAB 65536
+#define HL_MAX_LEVEL 80
+
+struct {
+	struct hl_node **buckets;
+	size_t nbuckets, count, limit;
+	struct hl_node *free;
+	struct hl_node *leaf[2];
+	struct hl_node *empty[HL_MAX_LEVEL];
+	struct hl_node *root; // centred on the plane's origin
+	uint32_t rule, epoch;
+} hl;
+
+static size_t hl_hash(struct hl_node *nw, struct hl_node *ne,
+		struct hl_node *sw, struct hl_node *se)
+{
+	uint64_t h = (uintptr_t)nw;
+	h = h * 0x9e3779b97f4a7c15 + (uintptr_t)ne;
+	h = h * 0x9e3779b97f4a7c15 + (uintptr_t)sw;
+	h = h * 0x9e3779b97f4a7c15 + (uintptr_t)se;
+	return (h ^ h >> 29) & (hl.nbuckets - 1);
+}
+
+// NULL when out of memory, which every builder below passes on, so a leap
+// that runs out comes back NULL with the tree it started from intact.
+static struct hl_node *hl_alloc(void)
+{
+	if (!hl.free) {
+		struct hl_node *slab = calloc(HL_SLAB, sizeof(*slab));
+		if (!slab)
+			return NULL;
+		for (size_t i = 0; i < HL_SLAB; i++) {
+			slab[i].next = hl.free;
+			hl.free = &slab[i];
+		}
+	}
+
+	struct hl_node *n = hl.free;
+	hl.free = n->next;
+	return n;
+}
+
+// Short of memory the table stays as it is, its chains only growing longer.
+static int hl_rehash(size_t nbuckets)
+{
+	struct hl_node **old = hl.buckets;
+	size_t nold = hl.nbuckets;
+	struct hl_node **buckets = calloc(nbuckets, sizeof(*hl.buckets));
+
+	if (!buckets)
+		return -ENOMEM;
+	hl.buckets = buckets;
+	hl.nbuckets = nbuckets;
+
+	for (size_t i = 0; i < nold; i++) {
+		struct hl_node *n = old[i], *next;
+		for (; n; n = next) {
+			next = n->next;
+			size_t h = hl_hash(n->nw, n->ne, n->sw, n->se);
+			n->next = hl.buckets[h];
+			hl.buckets[h] = n;
+		}
+	}
+	free(old);
+	return 0;
+}
+
+// The one node with these quadrants, or NULL if one of them is.
+static struct hl_node *hl_join(struct hl_node *nw, struct hl_node *ne,
+		struct hl_node *sw, struct hl_node *se)
+{
+	if (!(nw && ne && sw && se))
+		return NULL;
+
+	size_t h = hl_hash(nw, ne, sw, se);
+
+	for (struct hl_node *n = hl.buckets[h]; n; n = n->next)
+		if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se)
+			return n;
+
+	struct hl_node *n = hl_alloc();
+	if (!n)
+		return NULL;
+	*n = (struct hl_node){
+		.nw = nw, .ne = ne, .sw = sw, .se = se,
+		.pop = nw->pop + ne->pop + sw->pop + se->pop,
+		.level = nw->level + 1,
+		.next = hl.buckets[h],
+	};
+	hl.buckets[h] = n;
+
+	if (++hl.count > hl.nbuckets)
+		hl_rehash(2 * hl.nbuckets);
+
+	return n;
+}
+
+static struct hl_node *hl_centre(struct hl_node *n)
+{
+	return n ? hl_join(n->nw->se, n->ne->sw, n->sw->ne, n->se->nw) : NULL;
+}
+
+static struct hl_node *hl_centre_h(struct hl_node *w, struct hl_node *e)
+{
+	return hl_join(w->ne, e->nw, w->se, e->sw);
+}
+
+static struct hl_node *hl_centre_v(struct hl_node *n, struct hl_node *s)
+{
+	return hl_join(n->sw, n->se, s->nw, s->ne);
+}
+
+// A level 2 node is small enough to step by hand: its 2x2 centre one
+// generation on.
+static struct hl_node *hl_base(struct hl_node *n)
+{
+	struct hl_node *q[4] = { n->nw, n->ne, n->sw, n->se };
+	uint8_t g[4][4], next[2][2];
+
+	for (int i = 0; i < 4; i++) {
+		int x = (i & 1) * 2, y = (i >> 1) * 2;
+		g[y][x] = q[i]->nw->pop;
+		g[y][x + 1] = q[i]->ne->pop;
+		g[y + 1][x] = q[i]->sw->pop;
+		g[y + 1][x + 1] = q[i]->se->pop;
+	}
+
+	for (int y = 1; y < 3; y++)
+		for (int x = 1; x < 3; x++) {
+			int k = g[y-1][x-1] + g[y-1][x] + g[y-1][x+1]
+				+ g[y][x-1] + g[y][x+1]
+				+ g[y+1][x-1] + g[y+1][x] + g[y+1][x+1];
+			next[y-1][x-1] = !!(hl.rule &
+				(g[y][x] ? survive_bit(k) : birth_bit(k)));
+		}
+
+	return hl_join(hl.leaf[next[0][0]], hl.leaf[next[0][1]],
+			hl.leaf[next[1][0]], hl.leaf[next[1][1]]);
+}
+
+// The centre of n (a node one level down) 2^min(j, level-2) generations on.
+static struct hl_node *hl_successor(struct hl_node *n, uint32_t j)
+{
+	if (!n)
+		return NULL;
+
+	int full = j >= n->level - 2;
+
+	if (full && n->result)
+		return n->result;
+	if (!full && n->slow && n->slow_j == j)
+		return n->slow;
+
+	struct hl_node *r;
+	if (n->pop == 0) {
+		r = hl.empty[n->level - 1];
+	} else if (n->level == 2) {
+		r = hl_base(n);
+	} else {
+		// Nine overlapping nodes a level down tile the centre...
+		struct hl_node *m[9] = {
+			n->nw, hl_centre_h(n->nw, n->ne), n->ne,
+			hl_centre_v(n->nw, n->sw), hl_centre(n), hl_centre_v(n->ne, n->se),
+			n->sw, hl_centre_h(n->sw, n->se), n->se,
+		};
+
+		// ...which at full speed are stepped once here and once more
+		// below; otherwise only the second step moves time on.
+		for (int i = 0; i < 9; i++)
+			m[i] = full ? hl_successor(m[i], j) : hl_centre(m[i]);
+
+		r = hl_join(
+			hl_successor(hl_join(m[0], m[1], m[3], m[4]), j),
+			hl_successor(hl_join(m[1], m[2], m[4], m[5]), j),
+			hl_successor(hl_join(m[3], m[4], m[6], m[7]), j),
+			hl_successor(hl_join(m[4], m[5], m[7], m[8]), j));
+	}
+
+	if (!r)
+		return NULL;
+	if (full) {
+		n->result = r;
+	} else {
+		n->slow = r;
+		n->slow_j = j;
+	}
+	return r;
+}
+
+static struct hl_node *hl_expand(struct hl_node *n)
+{
+	if (!n)
+		return NULL;
+
+	struct hl_node *e = hl.empty[n->level - 1];
+
+	return hl_join(hl_join(e, e, e, n->nw), hl_join(e, e, n->ne, e),
+			hl_join(e, n->sw, e, e), hl_join(n->se, e, e, e));
+}
+
+// Whether everything in n lies in its centre half.
+static int hl_fits(struct hl_node *n)
+{
+	uint64_t inner = n->nw->se->pop + n->ne->sw->pop
+		+ n->sw->ne->pop + n->se->nw->pop;
+
+	return inner == n->pop;
+}
+
+static void hl_forget(void)
+{
+	for (size_t i = 0; i < hl.nbuckets; i++)
+		for (struct hl_node *n = hl.buckets[i]; n; n = n->next)
+			n->result = n->slow = NULL;
+}
+
+static void hl_mark(struct hl_node *n)
+{
+	if (n->mark == hl.epoch)
+		return;
+	n->mark = hl.epoch;
+	if (n->level > 0) {
+		hl_mark(n->nw);
+		hl_mark(n->ne);
+		hl_mark(n->sw);
+		hl_mark(n->se);
+	}
+}
+
+// Drop every node the root can't reach. Memoised results are dropped too,
+// they are only a cache.
+static void hl_collect(void)
+{
+	hl.epoch++;
+	hl_mark(hl.root);
+	for (int i = 0; i < HL_MAX_LEVEL && hl.empty[i]; i++)
+		hl_mark(hl.empty[i]);
+
+	for (size_t i = 0; i < hl.nbuckets; i++) {
+		struct hl_node **p = &hl.buckets[i];
+		while (*p) {
+			struct hl_node *n = *p;
+			if (n->mark == hl.epoch) {
+				n->result = n->slow = NULL;
+				p = &n->next;
+				continue;
+			}
+			*p = n->next;
+			n->next = hl.free;
+			hl.free = n;
+			hl.count--;
+		}
+	}
+
+	// still full of live nodes: let the table grow
+	if (hl.count > hl.limit / 2)
+		hl.limit *= 2;
+}
+
+int hashlife_init(struct landscape *l)
+{
+	hl.limit = 1 << 22;
+	if (hl_rehash(1 << 16) < 0)
+		return -ENOMEM;
+
+	for (int i = 0; i < 2; i++) {
+		hl.leaf[i] = calloc(1, sizeof(struct hl_node));
+		if (!hl.leaf[i])
+			return -ENOMEM;
+		hl.leaf[i]->pop = i;
+	}
+
+	hl.empty[0] = hl.leaf[0];
+	for (int i = 1; i < HL_MAX_LEVEL; i++)
+		if (!(hl.empty[i] = hl_join(hl.empty[i-1], hl.empty[i-1],
+				hl.empty[i-1], hl.empty[i-1])))
+			return -ENOMEM;
+	hl.root = hl.empty[3];
+	hl.rule = l->rule;
+
+	return 0;
+}
+
+// The landscape's (0, 0) sits at (-width/2, -height/2) on the plane.
+static struct hl_node *hl_build(struct landscape *l, uint32_t level,
+		int64_t x0, int64_t y0)
+{
+	int64_t size = (int64_t)1 << level;
+	int64_t lx = x0 + (int64_t)l->width / 2, ly = y0 + (int64_t)l->height / 2;
+
+	if (lx >= (int64_t)l->width || ly >= (int64_t)l->height
+			|| lx + size <= 0 || ly + size <= 0)
+		return hl.empty[level];
+	if (level == 0)
+		return hl.leaf[!!*landscape_at(l, l->show, lx, ly)];
+
+	int64_t half = size / 2;
+	return hl_join(hl_build(l, level - 1, x0, y0),
+			hl_build(l, level - 1, x0 + half, y0),
+			hl_build(l, level - 1, x0, y0 + half),
+			hl_build(l, level - 1, x0 + half, y0 + half));
+}
+
+void hashlife_pack(struct landscape *l)
+{
+	uint32_t level = 3;
+
+	while (((int64_t)1 << (level - 1)) < (int64_t)(l->width > l->height ?
+				l->width : l->height))
+		level++;
+
+	struct hl_node *root = hl_build(l, level,
+			-((int64_t)1 << (level - 1)), -((int64_t)1 << (level - 1)));
+	if (!root) {
+		// the old tree is no use now; make room and try again
+		hl.root = hl.empty[3];
+		hl_collect();
+		root = hl_build(l, level, -((int64_t)1 << (level - 1)),
+				-((int64_t)1 << (level - 1)));
+	}
+	if (!root)
+		fprintf(stderr, "hashlife: no mem for the landscape\n");
+	hl.root = root ? root : hl.empty[3];
+}
+
+static void hl_raster(struct landscape *l, struct hl_node *n,
+		int64_t x0, int64_t y0)
+{
+	int64_t size = (int64_t)1 << n->level;
+	int64_t lx = x0 + (int64_t)l->width / 2, ly = y0 + (int64_t)l->height / 2;
+
+	if (n->pop == 0 || lx >= (int64_t)l->width || ly >= (int64_t)l->height
+			|| lx + size <= 0 || ly + size <= 0)
+		return;
+	if (n->level == 0) {
+		*landscape_at(l, l->show, lx, ly) = 1;
+		return;
+	}
+
+	int64_t half = size / 2;
+	hl_raster(l, n->nw, x0, y0);
+	hl_raster(l, n->ne, x0 + half, y0);
+	hl_raster(l, n->sw, x0, y0 + half);
+	hl_raster(l, n->se, x0 + half, y0 + half);
+}
+
+void hashlife_unpack(struct landscape *l)
+{
+	struct hl_node *n = hl.root;
+
+	for (size_t y = 0; y < l->height; y++)
+		memset(landscape_row(l, l->show, y), 0, l->width);
+
+	// the window is near the origin; far out levels only overflow
+	while (n && n->level > 48)
+		n = hl_centre(n);
+	if (!n) {
+		fprintf(stderr, "hashlife: no mem to show the landscape\n");
+		return;
+	}
+	hl_raster(l, n, -((int64_t)1 << (n->level - 1)),
+			-((int64_t)1 << (n->level - 1)));
+}
+
+// The root 2^j generations on, or NULL, leaving hl.root as it was.
+static struct hl_node *hl_leap(uint32_t j)
+{
+	struct hl_node *root = hl.root;
+
+	// Step with room to spare: the pattern has to stay inside the
+	// result, which is the centre half of the root.
+	while (root && (root->level < j + 2 || !hl_fits(root)))
+		root = hl_expand(root);
+	root = hl_successor(hl_expand(root), j);
+
+	while (root && root->level > 3 && hl_fits(root))
+		root = hl_centre(root);
+	return root;
+}
+
+void hashlife_advance(struct landscape *l, size_t gens)
+{
+	if (l->automata != twod_life_like || (l->rule & birth_bit(0)) || l->rules
+			|| l->alpha < 256 || l->states > 2) {
+		// 1D rules, B0 (which fills the empty plane) and painted
+		// rules need a bounded landscape; coin tosses can't be
+		// remembered, nor can a node of two states hold the dying.
+		landscape_sync(l);
+		landscape_advance_bytes(l, gens);
+		l->engine_stale = 1;
+		return;
+	}
+
+	if (hl.rule != l->rule) {
+		hl_forget();
+		hl.rule = l->rule;
+	}
+
+	for (uint32_t j = 0; gens; j++, gens >>= 1) {
+		if (!(gens & 1))
+			continue;
+
+		if (hl.count > hl.limit)
+			hl_collect();
+
+		// Out of memory mid-leap, drop what it built and try again;
+		// failing that, the rest goes as bytes.
+		struct hl_node *root = hl_leap(j);
+		if (!root) {
+			hl_collect();
+			root = hl_leap(j);
+		}
+		if (!root) {
+			fprintf(stderr, "hashlife: no mem, stepping %zu "
+					"generations as bytes\n", gens << j);
+			hashlife_unpack(l);
+			l->show_stale = 0;
+			landscape_advance_bytes(l, gens << j);
+			l->engine_stale = 1;
+			return;
+		}
+		hl.root = root;
+	}
+
+	l->show_stale = 1;
+}
+
+// The tiled engine is the byte engine, but it only steps the parts of the
+// landscape that are still moving. The landscape is cut into TILE x TILE
+// tiles, each flagged with whether it changed last generation. A cell can
+// only change if something in its neighbourhood did, so a tile that didn't
+// change, and whose neighbours didn't either, is left alone. It doesn't even
+// need copying: the back buffer holds the generation before, which for such
+// a tile is the same.
+#define TILE LIFE_CHUNK // so the kernels flag changes per tile
+
+struct {
+	size_t tw, th; // [tiles]
+	uint8_t *changed[2]; // changed[cur] is last generation's
+	int cur;
+
+	// what the flags were computed under
+	uint32_t rule;
+	void (*quotient)(struct landscape *, uint8_t *, size_t, size_t);
+} tiles;
+
+int tiles_init(struct landscape *l)
+{
+	tiles.tw = (l->width + TILE - 1) / TILE;
+	tiles.th = (l->height + TILE - 1) / TILE;
+	tiles.changed[0] = malloc(tiles.tw * tiles.th);
+	tiles.changed[1] = malloc(tiles.tw * tiles.th);
+	if (!(tiles.changed[0] && tiles.changed[1]))
+		return -ENOMEM;
+	memset(tiles.changed[tiles.cur], 1, tiles.tw * tiles.th);
+
+	return 0;
+}
+
+// show was painted behind our back; the next generation is a full sweep
+void tiles_pack(struct landscape *l)
+{
+	memset(tiles.changed[tiles.cur], 1, tiles.tw * tiles.th);
+}
+
+// Which tiles of row ty have something in their neighbourhood that changed.
+// Edges wrap whatever the quotient; for clamped that's merely cautious.
+static void tiles_active(const uint8_t *was, size_t ty, uint8_t *active)
+{
+	size_t tw = tiles.tw, th = tiles.th;
+	const uint8_t *n = &was[(ty ? ty - 1 : th - 1) * tw];
+	const uint8_t *c = &was[ty * tw];
+	const uint8_t *s = &was[(ty + 1 < th ? ty + 1 : 0) * tw];
+	uint8_t v[tw];
+
+	for (size_t tx = 0; tx < tw; tx++)
+		v[tx] = n[tx] | c[tx] | s[tx];
+	for (size_t tx = 0; tx < tw; tx++)
+		active[tx] = v[tx ? tx - 1 : tw - 1] | v[tx] | v[tx + 1 < tw ? tx + 1 : 0];
+}
+
+// Rows of tiles [t0, t1). Runs of active tiles are stepped as one span.
+static void tiles_stripe(struct landscape *l, size_t gen, size_t t0, size_t t1)
+{
+	uint8_t *from = gen & 1 ? landscape_back(l) : l->show;
+	uint8_t *to = gen & 1 ? l->show : landscape_back(l);
+	const uint8_t *was = tiles.changed[(tiles.cur + gen) & 1];
+	uint8_t *now = tiles.changed[(tiles.cur + gen + 1) & 1];
+	uint8_t active[tiles.tw];
+	struct life_lut luts[RULES_MAX];
+	life_row_fn row = l->states > 2 ? gens_row : life_row;
+
+	if (l->rules)
+		rules_compile(l, luts);
+	else
+		life_lut_compile(l->rule, &luts[0]);
+
+	for (size_t ty = t0; ty < t1; ty++) {
+		size_t y0 = ty * TILE, y1 = y0 + TILE < l->height ? y0 + TILE : l->height;
+		uint8_t *changed = &now[ty * tiles.tw];
+
+		tiles_active(was, ty, active);
+		memset(changed, 0, tiles.tw);
+
+		for (size_t a = 0, b; a < tiles.tw; a = b) {
+			for (b = a; b < tiles.tw && active[b] == active[a]; b++)
+				;
+			if (!active[a])
+				continue;
+
+			size_t x0 = a * TILE, x1 = b * TILE < l->width ? b * TILE : l->width;
+			for (size_t y = y0; y < y1 && l->rules; y++)
+				rules_row(l, luts, from, to, x0, x1, y, &changed[a]);
+			for (size_t y = y0; y < y1 && !l->rules; y++) {
+				const uint8_t *c = landscape_at(l, from, x0, y);
+				uint8_t *out = landscape_at(l, to, x0, y);
+
+				row(out, c - l->stride, c, c + l->stride,
+						x1 - x0, &luts[0], &changed[a]);
+			}
+		}
+	}
+
+	l->quotient(l, to, t0 * TILE, t1 * TILE < l->height ? t1 * TILE : l->height);
+}
+
+void tiles_advance(struct landscape *l, size_t gens)
+{
+	// A tile whose cells all lost their tosses would look settled.
+	if (l->automata != twod_life_like || l->alpha < 256) {
+		landscape_advance_bytes(l, gens);
+		tiles_pack(l);
+		return;
+	}
+
+	if (l->rule != tiles.rule || l->quotient != tiles.quotient) {
+		tiles_pack(l);
+		tiles.rule = l->rule;
+		tiles.quotient = l->quotient;
+	}
+
+	l->quotient(l, l->show, 0, l->height);
+	pool_run(l, tiles_stripe, gens, tiles.th);
+
+	tiles.cur = (tiles.cur + gens) & 1;
+	if (gens & 1)
+		l->show = landscape_back(l);
+}
+
+// The plane engine has no edges: the landscape is a window on an unbounded
+// plane. The plane is kept as PLANE_TILE x PLANE_TILE tiles of packed rows,
+// found through an open-addressing table keyed by tile coordinates. Only
+// tiles with something alive in them exist, plus, for the length of a
+// generation, the empty ones next door that something could be born into,
+// so memory and step time go with the population rather than the bounding
+// box. Tiles come from a pool and go back to it as they empty.
+#define PLANE_TILE 64 // a word per row
+
+struct plane_tile {
+	int32_t tx, ty;
+	uint64_t rows[2][PLANE_TILE]; // by generation parity
+};
+
+struct {
+	struct plane_tile *tile;
+	uint32_t *live, *free; // indices into tile
+	size_t ntiles, nlive, nfree, cap;
+	int cur;
+
+	uint32_t *slots; // linear probing; tile index + 1, 0 for empty
+	size_t mask;
+
+	int64_t x0, y0; // the window's top left on the plane
+} plane;
+
+static const uint64_t plane_empty[PLANE_TILE];
+
+static inline size_t plane_hash(int32_t tx, int32_t ty)
+{
+	uint64_t k = (uint64_t)(uint32_t)tx << 32 | (uint32_t)ty;
+	return (k * 0x9e3779b97f4a7c15) >> 32;
+}
+
+static struct plane_tile *plane_find(int32_t tx, int32_t ty)
+{
+	for (size_t s = plane_hash(tx, ty) & plane.mask; plane.slots[s];
+			s = (s + 1) & plane.mask) {
+		struct plane_tile *t = &plane.tile[plane.slots[s] - 1];
+		if (t->tx == tx && t->ty == ty)
+			return t;
+	}
+	return NULL;
+}
+
+static void plane_slot(uint32_t i)
+{
+	const struct plane_tile *t = &plane.tile[i];
+	size_t s = plane_hash(t->tx, t->ty) & plane.mask;
+
+	while (plane.slots[s])
+		s = (s + 1) & plane.mask;
+	plane.slots[s] = i + 1;
+}
+
+static int plane_rehash(size_t n)
+{
+	uint32_t *slots = calloc(n, sizeof(uint32_t));
+	if (!slots)
+		return -ENOMEM;
+
+	free(plane.slots);
+	plane.slots = slots;
+	plane.mask = n - 1;
+	for (size_t i = 0; i < plane.nlive; i++)
+		plane_slot(plane.live[i]);
+	return 0;
+}
+
+// The tile at (tx, ty), made empty if there wasn't one. Returns its index,
+// which unlike a pointer survives the pool growing, or -ENOMEM.
+static long plane_get(int32_t tx, int32_t ty)
+{
+	struct plane_tile *t = plane_find(tx, ty);
+	uint32_t i;
+
+	if (t)
+		return t - plane.tile;
+
+	// keep the table at most half full
+	if (2 * (plane.nlive + 1) > plane.mask + 1
+			&& plane_rehash(2 * (plane.mask + 1)) < 0)
+		return -ENOMEM;
+
+	if (plane.nfree) {
+		i = plane.free[--plane.nfree];
+	} else {
+		if (plane.ntiles == plane.cap) {
+			size_t cap = plane.cap ? 2 * plane.cap : 256;
+			void *tile = realloc(plane.tile, cap * sizeof(*plane.tile));
+			if (tile)
+				plane.tile = tile;
+			void *live = realloc(plane.live, cap * sizeof(uint32_t));
+			if (live)
+				plane.live = live;
+			void *fr = realloc(plane.free, cap * sizeof(uint32_t));
+			if (fr)
+				plane.free = fr;
+			if (!(tile && live && fr))
+				return -ENOMEM;
+			plane.cap = cap;
+		}
+		i = plane.ntiles++;
+	}
+
+	t = &plane.tile[i];
+	t->tx = tx;
+	t->ty = ty;
+	memset(t->rows, 0, sizeof(t->rows));
+	plane.live[plane.nlive++] = i;
+	plane_slot(i);
+	return i;
+}
+
+// Take tile i out of the table. Later members of its probe run are shifted
+// back over the hole, so lookups never need tombstones.
+static void plane_remove(uint32_t i)
+{
+	const struct plane_tile *t = &plane.tile[i];
+	size_t s = plane_hash(t->tx, t->ty) & plane.mask;
+
+	while (plane.slots[s] != i + 1)
+		s = (s + 1) & plane.mask;
+
+	for (size_t j = (s + 1) & plane.mask; plane.slots[j];
+			j = (j + 1) & plane.mask) {
+		const struct plane_tile *u = &plane.tile[plane.slots[j] - 1];
+		size_t home = plane_hash(u->tx, u->ty) & plane.mask;
+
+		// u can fill the hole if its home isn't between the two
+		if (((j - home) & plane.mask) >= ((j - s) & plane.mask)) {
+			plane.slots[s] = plane.slots[j];
+			s = j;
+		}
+	}
+	plane.slots[s] = 0;
+}
+
+// Hand tiles with nothing alive in them back to the pool.
+static void plane_shed(void)
+{
+	size_t n = 0;
+
+	for (size_t k = 0; k < plane.nlive; k++) {
+		uint32_t i = plane.live[k];
+		const uint64_t *r = plane.tile[i].rows[plane.cur];
+		uint64_t any = 0;
+
+		for (int y = 0; y < PLANE_TILE; y++)
+			any |= r[y];
+		if (any) {
+			plane.live[n++] = i;
+			continue;
+		}
+		plane_remove(i);
+		plane.free[plane.nfree++] = i;
+	}
+	plane.nlive = n;
+}
+
+// Make room for the next generation: every neighbour that something on a
+// tile's edge could give birth into has to exist.
+static int plane_expand(void)
+{
+	for (size_t k = 0, n = plane.nlive; k < n; k++) {
+		const struct plane_tile *t = &plane.tile[plane.live[k]];
+		const uint64_t *r = t->rows[plane.cur];
+		int32_t tx = t->tx, ty = t->ty;
+		uint64_t any = 0;
+
+		for (int y = 0; y < PLANE_TILE; y++)
+			any |= r[y];
+		if (!any)
+			continue;
+
+		uint64_t top = r[0], bottom = r[PLANE_TILE - 1];
+		int edge[3][3] = {
+			{ top & 1, !!top, top >> 63 },
+			{ any & 1, 0, any >> 63 },
+			{ bottom & 1, !!bottom, bottom >> 63 },
+		};
+		for (int dy = 0; dy < 3; dy++)
+			for (int dx = 0; dx < 3; dx++)
+				if (edge[dy][dx] && plane_get(tx + dx - 1, ty + dy - 1) < 0)
+					return -ENOMEM;
+	}
+	return 0;
+}
+
+// Live tiles [k0, k1). Each is stepped with the packed kernel, the rows and
+// edge bits around it taken from its neighbours, or as empty where there
+// are none.
+static void plane_stripe(struct landscape *l, size_t gen, size_t k0, size_t k1)
+{
+	struct packed_rule pr;
+	packed_rule_compile(l->rule, &pr);
+
+	for (size_t k = k0; k < k1; k++) {
+		struct plane_tile *t = &plane.tile[plane.live[k]];
+		const uint64_t *n[3][3];
+		uint64_t s0[PLANE_TILE + 2], s1[PLANE_TILE + 2];
+
+		for (int dy = 0; dy < 3; dy++)
+			for (int dx = 0; dx < 3; dx++) {
+				const struct plane_tile *u = dx == 1 && dy == 1 ? t
+					: plane_find(t->tx + dx - 1, t->ty + dy - 1);
+				n[dy][dx] = u ? u->rows[plane.cur] : plane_empty;
+			}
+
+		for (int y = -1; y <= PLANE_TILE; y++) {
+			int dy = y < 0 ? 0 : y < PLANE_TILE ? 1 : 2;
+			int r = y < 0 ? PLANE_TILE - 1 : y < PLANE_TILE ? y : 0;
+			uint64_t c = n[dy][1][r];
+
+			packed_add3(c << 1 | n[dy][0][r] >> 63, c,
+					c >> 1 | n[dy][2][r] << 63,
+					&s0[y + 1], &s1[y + 1]);
+		}
+
+		const uint64_t *alive = t->rows[plane.cur];
+		uint64_t *out = t->rows[!plane.cur];
+		for (int y = 0; y < PLANE_TILE; y++)
+			out[y] = packed_rule_apply(&pr, s0[y], s1[y],
+					s0[y + 1], s1[y + 1], s0[y + 2], s1[y + 2],
+					alive[y]);
+	}
+}
+
+int plane_init(struct landscape *l)
+{
+	plane.x0 = -(int64_t)l->width / 2;
+	plane.y0 = -(int64_t)l->height / 2;
+	return plane_rehash(1024);
+}
+
+// The window's cells go onto the plane, replacing whatever was there.
+void plane_pack(struct landscape *l)
+{
+	for (size_t y = 0; y < l->height; y++) {
+		const uint8_t *cells = landscape_row(l, l->show, y);
+		int64_t py = plane.y0 + (int64_t)y;
+
+		for (size_t x = 0, n; x < l->width; x += n) {
+			int64_t px = plane.x0 + (int64_t)x;
+			size_t b = px & (PLANE_TILE - 1);
+			n = PLANE_TILE - b < l->width - x ? PLANE_TILE - b : l->width - x;
+
+			uint64_t bits = 0;
+			uint64_t mask = (n == 64 ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1) << b;
+			for (size_t i = 0; i < n; i++)
+				bits |= (uint64_t)!!cells[x + i] << (b + i);
+
+			struct plane_tile *t = plane_find(px >> 6, py >> 6);
+			if (!t && bits) {
+				long i = plane_get(px >> 6, py >> 6);
+				if (i < 0) {
+					fprintf(stderr, "out of memory for the plane\n");
+					return;
+				}
+				t = &plane.tile[i];
+			}
+			if (t) {
+				uint64_t *r = &t->rows[plane.cur][py & (PLANE_TILE - 1)];
+				*r = (*r & ~mask) | bits;
+			}
+		}
+	}
+	plane_shed();
+}
+
+void plane_unpack(struct landscape *l)
+{
+	for (size_t y = 0; y < l->height; y++) {
+		uint8_t *cells = landscape_row(l, l->show, y);
+		int64_t py = plane.y0 + (int64_t)y;
+
+		for (size_t x = 0, n; x < l->width; x += n) {
+			int64_t px = plane.x0 + (int64_t)x;
+			size_t b = px & (PLANE_TILE - 1);
+			n = PLANE_TILE - b < l->width - x ? PLANE_TILE - b : l->width - x;
+
+			const struct plane_tile *t = plane_find(px >> 6, py >> 6);
+			uint64_t row = t ? t->rows[plane.cur][py & (PLANE_TILE - 1)] : 0;
+			for (size_t i = 0; i < n; i++)
+				cells[x + i] = row >> (b + i) & 1;
+		}
+	}
+}
+
+void plane_advance(struct landscape *l, size_t gens)
+{
+	if (l->automata != twod_life_like || (l->rule & birth_bit(0)) || l->rules
+			|| l->alpha < 256 || l->states > 2) {
+		// B0 fills the empty plane, and painted rules are painted on
+		// the window; both need a bounded landscape. The coins are
+		// tossed by window row and word, so stochastic steps too.
+		// Tiles hold the living only, so Generations as well.
+		landscape_sync(l);
+		landscape_advance_bytes(l, gens);
+		l->engine_stale = 1;
+		return;
+	}
+
+	// The tiles to step change every generation, so each is a job of its
+	// own.
+	for (size_t g = 0; g < gens; g++) {
+		if (plane_expand() < 0) {
+			fprintf(stderr, "out of memory for the plane\n");
+			break;
+		}
+		pool_run(l, plane_stripe, 1, plane.nlive);
+		plane.cur = !plane.cur;
+		plane_shed();
+	}
+	l->show_stale = 1;
+}
+
+// One dimensional automata only ever change their newest row, so the oned
+// engine keeps just that, 64 cells to a word, plus a ring of the last
+// `height` rows for show. Whatever the engine chosen with -e, 1D rules run
+// here.
+//
+// Shown, the landscape is a window on spacetime: the newest generation is the
+// bottom row once the ring has filled, and the rows above are its past. When
+// show is painted, its lowest live row becomes the newest generation.
+struct {
+	uint64_t *row, *next; // from word -1 to word `words`
+	uint64_t *ring; // height rows of words
+	size_t words;
+	size_t head;    // ring row of the newest generation
+	size_t filled;  // generations in the ring, up to height
+} wolf;
+
+int oned_init(struct landscape *l)
+{
+	wolf.words = (l->width + 63) / 64;
+	// a guard word either side
+	wolf.row = calloc(wolf.words + 2, sizeof(uint64_t));
+	wolf.next = calloc(wolf.words + 2, sizeof(uint64_t));
+	wolf.ring = landscape_alloc(wolf.words * l->height * sizeof(uint64_t));
+	if (!(wolf.row && wolf.next && wolf.ring))
+		return -ENOMEM;
+	wolf.row++;
+	wolf.next++;
+	return 0;
+}
+
+static void oned_pack_row(struct landscape *l, const uint8_t *cells, uint64_t *row)
+{
+	memset(row, 0, wolf.words * sizeof(uint64_t));
+	for (size_t x = 0; x < l->width; x++)
+		row[x / 64] |= (uint64_t)(cells[x] & 1) << (x % 64);
+}
+
+void oned_pack(struct landscape *l)
+{
+	size_t newest = 0;
+
+	for (size_t y = 0; y < l->height; y++) {
+		uint8_t *cells = landscape_row(l, l->show, y);
+		oned_pack_row(l, cells, wolf.ring + y * wolf.words);
+		if (memchr(cells, 1, l->width))
+			newest = y;
+	}
+	memcpy(wolf.row, wolf.ring + newest * wolf.words,
+			wolf.words * sizeof(uint64_t));
+	wolf.head = newest;
+	wolf.filled = newest + 1;
+}
+
+void oned_unpack(struct landscape *l)
+{
+	size_t oldest = wolf.head + l->height - (wolf.filled - 1);
+
+	for (size_t y = 0; y < l->height; y++) {
+		uint8_t *cells = landscape_row(l, l->show, y);
+		const uint64_t *row = wolf.ring
+			+ (oldest + y) % l->height * wolf.words;
+
+		if (y >= wolf.filled) {
+			memset(cells, 0, l->width);
+			continue;
+		}
+		for (size_t x = 0; x < l->width; x++)
+			cells[x] = row[x / 64] >> (x % 64) & 1;
+	}
+}
+
+#define MUX(s, a, b) (((s) & (a)) | (~(s) & (b)))
+
+// Bit p of m for each cell's (l, c, r) pattern p: a three level mux.
+static inline uint64_t oned_mux(uint64_t L, uint64_t C, uint64_t R,
+		const uint64_t m[8])
+{
+	uint64_t r1 = MUX(R, m[7], m[6]), r0 = MUX(R, m[5], m[4]);
+	uint64_t q1 = MUX(R, m[3], m[2]), q0 = MUX(R, m[1], m[0]);
+	return MUX(L, MUX(C, r1, r0), MUX(C, q1, q0));
+}
+
+// Next row of an elementary automaton, generation g, a word at a time. Each
+// word is lined up with its left and right neighbours by shifting in a bit
+// from the words either side; the Wolfram number then picks the output for
+// each of the eight (l, c, r) patterns.
+//
+// With odds, each cell is live if a random 8 bit fraction is under its
+// pattern's odds. Both are bit-sliced, the odds a mux per bit, and compared a
+// bit at a time from the top.
+static void oned_row(struct landscape *l, uint64_t g, uint64_t *c, uint64_t *out)
+{
+	size_t w = l->width, n = wolf.words;
+	uint64_t first = c[0] & 1, last = c[(w - 1) / 64] >> (w - 1) % 64 & 1;
+	int wrap = l->quotient == quotient_torus;
+	uint64_t m[8], t[9][8]; // t[b] is bit b of the odds
+	uint64_t u[8 * NOISE_WORDS], f[NOISE_WORDS];
+
+	for (int p = 0; p < 8; p++) {
+		m[p] = -(uint64_t)(l->rule >> p & 1);
+		for (int b = 0; b < 9; b++)
+			t[b][p] = -(uint64_t)(l->odds[p] >> b & 1);
+	}
+
+	// The cells just past either edge go in the guard words, or in the
+	// unused top of the last word.
+	c[-1] = (wrap ? last : first) << 63;
+	c[n] = 0;
+	c[w / 64] &= ((uint64_t)1 << w % 64) - 1;
+	c[w / 64] |= (wrap ? first : last) << w % 64;
+
+	for (size_t i0 = 0; i0 < n; i0 += NOISE_WORDS) {
+		size_t k = n - i0 < NOISE_WORDS ? n - i0 : NOISE_WORDS;
+
+		if (l->odds_on)
+			noise_planes(l, g, 0, i0, k, 0, 8, u);
+		if (l->alpha < 256)
+			noise_follow(l, g, 0, i0, k, f);
+
+		for (size_t j = 0, i = i0; j < k; j++, i++) {
+			uint64_t L = c[i] << 1 | c[i - 1] >> 63;
+			uint64_t C = c[i];
+			uint64_t R = c[i] >> 1 | c[i + 1] << 63;
+			uint64_t next;
+
+			if (l->odds_on) {
+				// odds of 256 are under anything
+				uint64_t lt = oned_mux(L, C, R, t[8]), eq = ~lt;
+				for (int b = 7; b >= 0; b--) {
+					uint64_t tb = oned_mux(L, C, R, t[b]);
+					uint64_t ub = u[b * NOISE_WORDS + j];
+					lt |= eq & tb & ~ub;
+					eq &= ~(tb ^ ub);
+				}
+				next = lt;
+			} else
+				next = oned_mux(L, C, R, m);
+			out[i] = l->alpha < 256 ? MUX(f[j], next, C) : next;
+		}
+	}
+	if (w % 64)
+		out[n - 1] &= ((uint64_t)1 << w % 64) - 1;
+}
+#undef MUX
+
+void oned_advance(struct landscape *l, size_t gens)
+{
+	for (size_t g = 0; g < gens; g++) {
+		uint64_t *tmp;
+
+		oned_row(l, l->generation + g, wolf.row, wolf.next);
+		tmp = wolf.row, wolf.row = wolf.next, wolf.next = tmp;
+
+		// only the last height generations will be seen
+		if (gens - g <= l->height) {
+			wolf.head = (wolf.head + 1) % l->height;
+			memcpy(wolf.ring + wolf.head * wolf.words, wolf.row,
+					wolf.words * sizeof(uint64_t));
+		}
+	}
+	wolf.filled = gens >= l->height - wolf.filled ? l->height
+		: wolf.filled + gens;
+	l->show_stale = 1;
+}
+
+const struct engine oned_engine = {
+	.name = "oned", .init = oned_init, .advance = oned_advance,
+	.pack = oned_pack, .unpack = oned_unpack,
+};
+
+const struct engine engines[] = {
+	{ .name = "bytes", .advance = landscape_advance_bytes },
+	{ .name = "packed", .init = packed_init, .advance = packed_advance,
+	  .pack = packed_pack, .unpack = packed_unpack },
+	{ .name = "hashlife", .init = hashlife_init, .advance = hashlife_advance,
+	  .pack = hashlife_pack, .unpack = hashlife_unpack },
+	{ .name = "tiles", .init = tiles_init, .advance = tiles_advance,
+	  .pack = tiles_pack },
+	{ .name = "mapped", .init = mapped_init, .advance = mapped_advance,
+	  .pack = packed_pack, .unpack = packed_unpack },
+	{ .name = "plane", .init = plane_init, .advance = plane_advance,
+	  .pack = plane_pack, .unpack = plane_unpack },
+};
+
+const struct engine *landscape_engine(struct landscape *l)
+{
+	return l->automata == oned ? &oned_engine : l->engine;
+}
+
+// Where the time goes. Both threads time the stretches of work that make up
+// a frame into one ring of the last PROF_EVENTS spans; a span costs two
+// clock reads and an atomic add, so it's always on. I shows the HUD and
+// prints percentiles to stderr, and -T writes the ring as a Chrome trace
+// (chrome://tracing, Perfetto) at exit.
+enum prof_kind {
+	// simulation thread
+	prof_step, prof_cmds, prof_publish,
+	// display thread
+	prof_draw, prof_commit, prof_frame, prof_stall, prof_dispatch, prof_wait,
+	PROF_KINDS
+};
+
+static const char *const prof_names[PROF_KINDS] = {
+	[prof_step]	= "step",
+	[prof_cmds]	= "commands",
+	[prof_publish]	= "publish",
+	[prof_draw]	= "draw",
+	[prof_commit]	= "commit",
+	[prof_frame]	= "frame",    // commit to frame callback
+	[prof_stall]	= "stall",    // no buffer free to draw into
+	[prof_dispatch]	= "dispatch",
+	[prof_wait]	= "wait",
+};
+
+#define PROF_EVENTS 4096
+
+struct {
+	// meta is duration << 8 | kind + 1, so 0 is a slot never written. The
+	// fields are relaxed atomics: a reader racing a writer a lap ahead
+	// sees a mixed-up span, not undefined behaviour.
+	struct {
+		_Atomic uint64_t t0, meta;
+	} ring[PROF_EVENTS];
+	atomic_size_t head;
+
+	const char *trace;
+
+	// display thread: the frame in flight was committed at, buffers ran
+	// out at
+	uint64_t commit, stall;
+	uint32_t hud:1;
+} prof;
+
+static inline uint64_t prof_now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * (uint64_t)1000000000 + t.tv_nsec;
+}
+
+// A span of kind from t0 until now.
+static void prof_span(enum prof_kind kind, uint64_t t0)
+{
+	uint64_t t1 = prof_now();
+	size_t i = atomic_fetch_add_explicit(&prof.head, 1, memory_order_relaxed);
+
+	i %= PROF_EVENTS;
+	atomic_store_explicit(&prof.ring[i].t0, t0, memory_order_relaxed);
+	atomic_store_explicit(&prof.ring[i].meta, (t1 - t0) << 8 | (kind + 1),
+			memory_order_relaxed);
+}
+
+// Up to n of the latest durations of kind, newest first.
+static size_t prof_latest(enum prof_kind kind, uint64_t *out, size_t n)
+{
+	size_t head = atomic_load_explicit(&prof.head, memory_order_relaxed);
+	size_t m = 0;
+
+	for (size_t k = 0; k < PROF_EVENTS && k < head && m < n; k++) {
+		uint64_t meta = atomic_load_explicit(
+				&prof.ring[(head - 1 - k) % PROF_EVENTS].meta,
+				memory_order_relaxed);
+		if ((meta & 0xff) == kind + 1u)
+			out[m++] = meta >> 8;
+	}
+	return m;
+}
+
+static int prof_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+void prof_report(void)
+{
+	uint64_t d[PROF_EVENTS];
+
+	fprintf(stderr, "%-9s %6s %9s %9s %9s %9s  [ms]\n",
+			"", "n", "p50", "p90", "p99", "max");
+	for (int k = 0; k < PROF_KINDS; k++) {
+		size_t n = prof_latest(k, d, PROF_EVENTS);
+		if (!n)
+			continue;
+		qsort(d, n, sizeof(*d), prof_cmp);
+		fprintf(stderr, "%-9s %6zu %9.3f %9.3f %9.3f %9.3f\n",
+				prof_names[k], n, d[n / 2] / 1E6,
+				d[n * 9 / 10] / 1E6, d[n * 99 / 100] / 1E6,
+				d[n - 1] / 1E6);
+	}
+}
+
+// The ring as Chrome trace events, a thread per thread.
+int prof_write_trace(const char *path)
+{
+	size_t head = atomic_load(&prof.head);
+	size_t k = head > PROF_EVENTS ? head - PROF_EVENTS : 0;
+	FILE *f = fopen(path, "w");
+
+	if (!f)
+		return -errno;
+
+	fprintf(f, "{\"traceEvents\":[\n"
+		"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+		"\"args\":{\"name\":\"display\"}},\n"
+		"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+		"\"args\":{\"name\":\"simulation\"}}");
+	for (; k < head; k++) {
+		uint64_t t0 = atomic_load(&prof.ring[k % PROF_EVENTS].t0);
+		uint64_t meta = atomic_load(&prof.ring[k % PROF_EVENTS].meta);
+		int kind = (meta & 0xff) - 1;
+
+		if (kind < 0 || kind >= PROF_KINDS)
+			continue;
+		fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+				"\"ts\":%.3f,\"dur\":%.3f}", prof_names[kind],
+				kind <= prof_publish ? 2 : 1,
+				t0 / 1E3, (meta >> 8) / 1E3);
+	}
+	fprintf(f, "\n]}\n");
+
+	return fclose(f) ? -errno : 0;
+}
+
+// A population mipmap for drawing zoomed out: level k counts the live cells
+// in each 2^k x 2^k block. Level 1 is recounted from the cells, the levels
+// above only along rows that changed below them, so what it costs to keep
+// up is a pass over the cells (64 at a time when they're packed) plus
+// whatever actually moved. Level k counts up to 4^k, so each is kept as
+// narrow as that allows: level 1, the biggest, is a byte a block, two bits
+// a cell.
+#define MIP_LEVELS 15 // 4^15 still fits a uint32_t
+
+struct {
+	void *pop[MIP_LEVELS + 1]; // mip_size(k) bytes a block
+	uint8_t *dirty[MIP_LEVELS + 1]; // rows changed by the last update
+	size_t w[MIP_LEVELS + 1], h[MIP_LEVELS + 1];
+	void *row; // scratch, a row of any level
+	uint32_t levels;
+	uint32_t stale:1; // the cells have changed since
+} mip;
+
+// Levels needed to get the landscape down to one block.
+static uint32_t mip_depth(struct landscape *l)
+{
+	uint32_t k = 0;
+
+	while (k < MIP_LEVELS && ((l->width - 1) >> k || (l->height - 1) >> k))
+		k++;
+	return k;
+}
+
+// Bytes a block of level k: 4^3 fits a byte, 4^7 a short.
+static size_t mip_size(uint32_t k)
+{
+	return k <= 3 ? 1 : k <= 7 ? 2 : 4;
+}
+
+static uint32_t mip_at(uint32_t k, const void *row, size_t i)
+{
+	switch (mip_size(k)) {
+		case 1: return ((const uint8_t *)row)[i];
+		case 2: return ((const uint16_t *)row)[i];
+		default: return ((const uint32_t *)row)[i];
+	}
+}
+
+static void mip_put(uint32_t k, void *row, size_t i, uint32_t n)
+{
+	switch (mip_size(k)) {
+		case 1: ((uint8_t *)row)[i] = n; break;
+		case 2: ((uint16_t *)row)[i] = n; break;
+		default: ((uint32_t *)row)[i] = n; break;
+	}
+}
+
+static int mip_init(struct landscape *l)
+{
+	size_t widest = 0;
+
+	mip.levels = mip_depth(l);
+	for (uint32_t k = 1; k <= mip.levels; k++) {
+		mip.w[k] = (l->width + ((size_t)1 << k) - 1) >> k;
+		mip.h[k] = (l->height + ((size_t)1 << k) - 1) >> k;
+		mip.pop[k] = landscape_alloc(mip.w[k] * mip.h[k] * mip_size(k));
+		mip.dirty[k] = calloc(mip.h[k], 1);
+		if (!(mip.pop[k] && mip.dirty[k]))
+			return -ENOMEM;
+		if (mip.w[k] * mip_size(k) > widest)
+			widest = mip.w[k] * mip_size(k);
+	}
+	mip.row = malloc(widest);
+	if (!mip.row)
+		return -ENOMEM;
+	mip.stale = 1;
+	return 0;
+}
+
+// Row j of level 1 into out, from rows 2j and 2j + 1 of the cells.
+static void mip_count(struct landscape *l, int packed, size_t j, uint8_t *out)
+{
+	size_t w = l->width, y = 2 * j;
+	int pair = y + 1 < l->height;
+
+	if (packed) {
+		static const uint64_t zero;
+		const uint64_t *a = &l->packed[y * l->words];
+		const uint64_t *b = pair ? &l->packed[(y + 1) * l->words] : &zero;
+		const uint64_t m1 = 0x5555555555555555, m2 = 0x3333333333333333;
+
+		for (size_t i = 0; i < l->words; i++) {
+			uint64_t wa = a[i], wb = pair ? b[i] : 0;
+			// 2-bit sums of each pair of columns, then of the two rows,
+			// even and odd pairs apart as the sums need 3 bits
+			uint64_t pa = (wa & m1) + (wa >> 1 & m1);
+			uint64_t pb = (wb & m1) + (wb >> 1 & m1);
+			uint64_t even = (pa & m2) + (pb & m2);
+			uint64_t odd = (pa >> 2 & m2) + (pb >> 2 & m2);
+
+			for (size_t n = 0; n < 16; n++) {
+				size_t x = 32 * i + 2 * n;
+				if (x < mip.w[1])
+					out[x] = even >> 4 * n & 15;
+				if (x + 1 < mip.w[1])
+					out[x + 1] = odd >> 4 * n & 15;
+			}
+		}
+		return;
+	}
+
+	// only the living count, not a Generations rule's dying
+	const uint8_t *a = landscape_row(l, l->show, y);
+	const uint8_t *b = pair ? landscape_row(l, l->show, y + 1) : NULL;
+	for (size_t x = 0; x < w / 2; x++)
+		out[x] = (a[2*x] == 1) + (a[2*x + 1] == 1)
+			+ (b ? (b[2*x] == 1) + (b[2*x + 1] == 1) : 0);
+	if (w & 1)
+		out[w / 2] = (a[w - 1] == 1) + (b ? b[w - 1] == 1 : 0);
+}
+
+// Row j of level k into out, from level k - 1.
+static void mip_sum(uint32_t k, size_t j, void *out)
+{
+	size_t w = mip.w[k - 1], z = mip_size(k - 1);
+	const uint8_t *a = (const uint8_t *)mip.pop[k - 1] + 2 * j * w * z;
+	const uint8_t *b = 2 * j + 1 < mip.h[k - 1] ? a + w * z : NULL;
+
+	for (size_t x = 0; x < w / 2; x++)
+		mip_put(k, out, x, mip_at(k - 1, a, 2*x) + mip_at(k - 1, a, 2*x + 1)
+			+ (b ? mip_at(k - 1, b, 2*x) + mip_at(k - 1, b, 2*x + 1) : 0));
+	if (w & 1)
+		mip_put(k, out, w / 2, mip_at(k - 1, a, w - 1)
+			+ (b ? mip_at(k - 1, b, w - 1) : 0));
+}
+
+// Bring the mipmap up to date with the cells. `packed` says the packed rows
+// are the truth; otherwise show is.
+static int mip_update(struct landscape *l, int packed)
+{
+	if (!mip.levels && mip_init(l) < 0)
+		return -ENOMEM;
+	if (!mip.stale)
+		return 0;
+	if (!packed)
+		landscape_sync(l);
+
+	for (uint32_t k = 1; k <= mip.levels; k++) {
+		for (size_t j = 0; j < mip.h[k]; j++) {
+			size_t n = mip.w[k] * mip_size(k);
+			uint8_t *row = (uint8_t *)mip.pop[k] + j * n;
+
+			mip.dirty[k][j] = 0;
+			if (k > 1 && !mip.dirty[k - 1][2 * j]
+					&& !(2 * j + 1 < mip.h[k - 1] && mip.dirty[k - 1][2 * j + 1]))
+				continue;
+
+			if (k == 1)
+				mip_count(l, packed, j, mip.row);
+			else
+				mip_sum(k, j, mip.row);
+			if (memcmp(row, mip.row, n)) {
+				memcpy(row, mip.row, n);
+				mip.dirty[k][j] = 1;
+			}
+		}
+	}
+	mip.stale = 0;
+	return 0;
+}
+
+// Units are cw x ch pixels until zoomed out so far that both are 1, then
+// blocks grow instead.
+static void view_set_zoom(struct landscape *l, struct view *v, int32_t zoom)
+{
+	int32_t shrink = 0; // halvings of the cell size to get to a pixel
+	while ((l->cell_width | l->cell_height) >> shrink > 1)
+		shrink++;
+
+	if (zoom < -(shrink + (int32_t)mip_depth(l)))
+		zoom = -(shrink + (int32_t)mip_depth(l));
+	while (zoom > 0 && (l->cell_width | l->cell_height) << zoom > 256)
+		zoom--;
+
+	v->zoom = zoom;
+	v->block = zoom < -shrink ? -shrink - zoom : 0;
+	v->cw = zoom >= 0 ? l->cell_width << zoom : l->cell_width >> -zoom;
+	v->ch = zoom >= 0 ? l->cell_height << zoom : l->cell_height >> -zoom;
+	v->cw += !v->cw;
+	v->ch += !v->ch;
+	v->vw = (v->pw + v->cw - 1) / v->cw;
+	v->vh = (v->ph + v->ch - 1) / v->ch;
+}
+
+static int64_t view_clamp1(int64_t x, int64_t span, int64_t size, int inside)
+{
+	int64_t lo = -span / 2, hi = size - span / 2;
+
+	if (inside) {
+		lo = 0;
+		hi = size - span;
+		if (hi < lo)
+			lo = hi = hi / 2;
+	}
+	return x < lo ? lo : x > hi ? hi : x;
+}
+
+// Keep the middle of the view on the landscape, or on the plane, where
+// there's always more to see, all of it; and the corner on a block. (dx, dy)
+// are how far it had to be pulled back, in cells.
+static void view_clamp(struct landscape *l, struct view *v,
+		int64_t *dx, int64_t *dy)
+{
+	int inside = landscape_engine(l)->advance == plane_advance;
+	int64_t x = v->x0, y = v->y0;
+
+	v->x0 = view_clamp1(v->x0, (int64_t)v->vw << v->block, l->width, inside);
+	v->y0 = view_clamp1(v->y0, (int64_t)v->vh << v->block, l->height, inside);
+	v->x0 &= -((int64_t)1 << v->block);
+	v->y0 &= -((int64_t)1 << v->block);
+
+	if (dx)
+		*dx = x - v->x0;
+	if (dy)
+		*dy = y - v->y0;
+}
+
+// Zoom in (dz > 0) or out about the window pixel (px, py), keeping the cell
+// under it put.
+void view_zoom(struct landscape *l, struct view *v, int32_t dz,
+		int32_t px, int32_t py)
+{
+	int64_t cx = v->x0 + px * ((int64_t)1 << v->block) / v->cw;
+	int64_t cy = v->y0 + py * ((int64_t)1 << v->block) / v->ch;
+
+	view_set_zoom(l, v, v->zoom + dz);
+	v->x0 = cx - px * ((int64_t)1 << v->block) / v->cw;
+	v->y0 = cy - py * ((int64_t)1 << v->block) / v->ch;
+	view_clamp(l, v, NULL, NULL);
+}
+
+// The window starts as big as the landscape at the cell size asked for, up
+// to WINDOW_MAX; a landscape too big for that starts zoomed out until it
+// fits, or as far as it goes.
+void view_init(struct landscape *l, struct view *v)
+{
+	*v = (struct view){ .pw = 1, .ph = 1 };
+	for (int32_t zoom = 0; ; zoom--) {
+		view_set_zoom(l, v, zoom);
+		if (v->zoom != zoom)
+			break;
+		if (((l->width - 1) >> v->block) + 1 <= WINDOW_MAX_W / v->cw
+				&& ((l->height - 1) >> v->block) + 1 <= WINDOW_MAX_H / v->ch)
+			break;
+	}
+
+	uint64_t pw = (((l->width - 1) >> v->block) + 1) * v->cw;
+	uint64_t ph = (((l->height - 1) >> v->block) + 1) * v->ch;
+	v->pw = pw < WINDOW_MAX_W ? pw : WINDOW_MAX_W;
+	v->ph = ph < WINDOW_MAX_H ? ph : WINDOW_MAX_H;
+	view_set_zoom(l, v, v->zoom);
+	view_clamp(l, v, NULL, NULL);
+}
+
+// The window is now pw x ph; the view keeps its zoom and its corner.
+void view_resize(struct landscape *l, struct view *v, uint32_t pw, uint32_t ph)
+{
+	v->pw = pw;
+	v->ph = ph;
+	view_set_zoom(l, v, v->zoom);
+	view_clamp(l, v, NULL, NULL);
+}
+
+// The landscape cell under the window pixel (px, py), or -1.
+int64_t view_cell(struct landscape *l, const struct view *v,
+		int32_t px, int32_t py)
+{
+	if (!v->cw || px < 0 || py < 0)
+		return -1;
+
+	int64_t x = v->x0 + ((int64_t)px << v->block) / v->cw;
+	int64_t y = v->y0 + ((int64_t)py << v->block) / v->ch;
+	if (x < 0 || y < 0 || x >= (int64_t)l->width || y >= (int64_t)l->height)
+		return -1;
+	return y * l->width + x;
+}
+
+// The view's units as states to draw, from whichever copy of the cells is
+// the truth, or zoomed out, from the mipmap. The cost goes with the window,
+// not the landscape, bar keeping the mipmap up.
+static void view_looks(struct landscape *l, const struct view *v, uint8_t *looks)
+{
+	int packed = landscape_engine(l)->unpack == packed_unpack
+		&& !l->engine_stale;
+	uint32_t b = v->block;
+
+	if (b && mip_update(l, packed) < 0)
+		b = 0;
+	if (!b && !packed)
+		landscape_sync(l);
+
+	int64_t lw = b ? mip.w[b] : l->width, lh = b ? mip.h[b] : l->height;
+	int64_t bx = v->x0 >> b, by = v->y0 >> b;
+	int64_t i0 = bx < 0 ? -bx : 0;
+	int64_t i1 = lw - bx < (int64_t)v->vw ? lw - bx : v->vw;
+
+	for (int64_t j = 0; j < v->vh; j++) {
+		uint8_t *out = looks + j * v->vw;
+		int64_t y = by + j;
+
+		memset(out, cell_void, v->vw);
+		if (y < 0 || y >= lh)
+			continue;
+
+		if (b) {
+			const uint8_t *pop = (const uint8_t *)mip.pop[b]
+				+ y * lw * mip_size(b);
+			int64_t side = (int64_t)1 << b;
+			int64_t hy = (int64_t)l->height - (y << b);
+			hy = hy < side ? hy : side;
+			for (int64_t i = i0; i < i1; i++) {
+				int64_t x = bx + i, wx = (int64_t)l->width - (x << b);
+				uint64_t area = (wx < side ? wx : side) * hy;
+				uint32_t n = mip_at(b, pop, x);
+				out[i] = n ? cell_dense + (n
+					* (uint64_t)DENSITY_LEVELS - 1) / area : cell_off;
+			}
+		} else if (packed && l->states > 2) {
+			for (int64_t i = i0; i < i1; i++)
+				out[i] = packed_state(l, bx + i, y);
+		} else if (packed) {
+			const uint64_t *row = &l->packed[y * l->words];
+			for (int64_t i = i0; i < i1; i++)
+				out[i] = packed_cell(row, bx + i);
+		} else if (i1 > i0) {
+			memcpy(out + i0, landscape_row(l, l->show, y) + bx + i0,
+					i1 - i0);
+		}
+
+		if (!b && l->rules) {
+			const uint8_t *map = &l->rules[y / RULE_TILE * l->rules_w];
+			for (int64_t i = i0; i < i1; i++)
+				if (!out[i] && map[(bx + i) / RULE_TILE])
+					out[i] = cell_ruled;
+		}
+	}
+}
+
+// The simulation runs on a thread of its own, which owns the landscape
+// outright. The display hands it edits through a ring of commands, applied
+// between generations, and it hands back generations through a triple
+// buffer of snapshots: one being written, one being drawn and one in the
+// middle to swap with. Neither side ever waits on the other.
+#define SIM_CMDS 1024
+#define SNAP_FRESH 4 // the middle snapshot hasn't been picked up yet
+
+struct sim_cmd {
+	void (*apply)(struct landscape *l, const struct sim_cmd *c);
+	int32_t x, y;
+	uint32_t arg;
+	void (*brush)(struct landscape *l, int x, int y);
+};
+
+struct {
+	pthread_t thread;
+	int wake, ready; // eventfds: display -> simulation, and back
+	int timer; // timerfd, under pace_rate
+	int tick; // eventfd, a frame was shown, under pace_frame
+
+	struct sim_cmd cmds[SIM_CMDS];
+	atomic_size_t head, tail; // advanced by the display, by the simulation
+	atomic_uint quit; // set by the display, outside the ring so it can't drop
+
+	struct snap {
+		struct view view;
+		uint8_t *looks; // view.vw x view.vh
+		size_t size; // of looks
+		uint32_t states; // the cells', for the palette
+	} snaps[3];
+	atomic_uint middle;
+	uint32_t back, front;
+
+	// the simulation's own
+	struct view view;
+	uint32_t pace, rate, per_frame;
+	uint64_t due; // generations to step
+	uint64_t owed; // [generation ns] towards the next, under pace_rate
+	uint64_t batch; // generations a go, under pace_free
+	uint32_t paused:1,
+		dirty:1;
+} sim;
+
+void landscape_debug(struct landscape *l, int x, int y)
+{
+	landscape_sync(l);
+	fprintf(stderr, "%d %d %d\n%d %d %d\n%d %d %d\n\n",
+			landscape_get(l, x - 1, y - 1),
+			landscape_get(l, x,     y - 1),
+			landscape_get(l, x + 1, y - 1),
+
+			landscape_get(l, x - 1, y),
+			landscape_get(l, x,     y),
+			landscape_get(l, x + 1, y),
+
+			landscape_get(l, x - 1, y + 1),
+			landscape_get(l, x,     y + 1),
+			landscape_get(l, x + 1, y + 1));
+}
+
+static void print_rule(struct landscape *l)
+{
+	char buf[48];
+
+	if (l->automata == twod_life_like)
+		print_lifelike_rule(l->rule);
+	else if (l->automata == twod_larger)
+		fprintf(stdout, "%s\n", format_ltl_rule(&l->ltl, buf, sizeof(buf)));
+	else
+		fprintf(stderr, "wolfram number: %d\n", l->rule & 0xff);
+}
+
+// The commands. Each runs on the simulation thread.
+void cmd_paint(struct landscape *l, const struct sim_cmd *c)
+{
+	landscape_sync(l);
+	*landscape_at(l, l->show, c->x, c->y) = c->arg;
+	landscape_touch(l);
+}
+
+void cmd_toggle(struct landscape *l, const struct sim_cmd *c)
+{
+	landscape_sync(l);
+	uint8_t *cell = landscape_at(l, l->show, c->x, c->y);
+	*cell = !*cell;
+	landscape_touch(l);
+}
+
+void cmd_brush(struct landscape *l, const struct sim_cmd *c)
+{
+	c->brush(l, c->x, c->y);
+}
+
+void cmd_reset(struct landscape *l, const struct sim_cmd *c)
+{
+	memset(l->flip, 0, l->stride * (l->height + 2));
+	memset(l->flop, 0, l->stride * (l->height + 2));
+	l->show_stale = 0;
+	if (l->automata == oned)
+		*landscape_at(l, l->show, l->width/2, 0) = 1;
+	landscape_touch(l);
+	sim.paused = 1;
+}
+
+// Under pace_rate the timer goes off every 1/rate s, or every ms past a
+// thousand a second with the generations it's worth carried over in owed.
+static uint64_t sim_period(void)
+{
+	return sim.rate > 1000 ? 1000000 : 1000000000 / sim.rate;
+}
+
+// Paused, nothing wakes the simulation but the display. Paced by frames, the
+// first generations are on us; the rest come from the frames they're shown
+// in.
+static void sim_repace(void)
+{
+	struct itimerspec its = {0};
+
+	if (!sim.paused && sim.pace == pace_rate) {
+		uint64_t ns = sim_period();
+		its.it_interval.tv_sec = ns / 1000000000;
+		its.it_interval.tv_nsec = ns % 1000000000;
+		its.it_value = its.it_interval;
+	}
+	timerfd_settime(sim.timer, 0, &its, NULL);
+	sim.owed = 0;
+	sim.due = !sim.paused && sim.pace == pace_frame ? sim.per_frame : 0;
+}
+
+void cmd_pause(struct landscape *l, const struct sim_cmd *c)
+{
+	sim.paused = c->arg;
+	sim_repace();
+}
+
+// arg is the pace, x the generations a second and y those a frame
+void cmd_pace(struct landscape *l, const struct sim_cmd *c)
+{
+	sim.pace = c->arg;
+	sim.rate = c->x;
+	sim.per_frame = c->y;
+	sim_repace();
+}
+
+// step 2^arg generations
+// Only hashlife leaps further than LEAP_MAX: any other engine would hold the
+// simulation thread, and so quitting, for as long as the leap takes.
+void cmd_step(struct landscape *l, const struct sim_cmd *c)
+{
+	uint32_t leap = c->arg;
+
+	if (leap > LEAP_MAX && landscape_engine(l)->advance != hashlife_advance) {
+		fprintf(stderr, "leap: 2^%u is for hashlife, 2^%u instead\n",
+				leap, LEAP_MAX);
+		leap = LEAP_MAX;
+	}
+	landscape_advance(l, (size_t)1 << leap);
+	if (leap)
+		fprintf(stderr, "leapt 2^%u generations\n", leap);
+}
+
+void cmd_debug(struct landscape *l, const struct sim_cmd *c)
+{
+	landscape_debug(l, c->x, c->y);
+}
+
+// With x set, these change the brush's ink rather than the landscape's rule.
+void cmd_rule(struct landscape *l, const struct sim_cmd *c)
+{
+	*(c->x ? &l->ink : &l->rule) = c->arg;
+}
+
+// arg is added to the rule's counts; a Generations rule keeps its states
+static uint32_t rule_add(uint32_t rule, uint32_t arg)
+{
+	return (rule & ~RULE_COUNTS) | ((rule + arg) & RULE_COUNTS);
+}
+
+void cmd_rule_add(struct landscape *l, const struct sim_cmd *c)
+{
+	if (c->x) {
+		l->ink = rule_add(l->ink, c->arg);
+		print_lifelike_rule(l->ink);
+		return;
+	}
+	l->rule = rule_add(l->rule, c->arg);
+	print_rule(l);
+}
+
+// arg is added to alpha, the chance in 256 that a cell steps
+void cmd_alpha_add(struct landscape *l, const struct sim_cmd *c)
+{
+	int32_t a = (int32_t)l->alpha + (int32_t)c->arg;
+
+	l->alpha = a < 0 ? 0 : a > 256 ? 256 : a;
+	fprintf(stderr, "alpha: %.4f\n", l->alpha / 256.0);
+}
+
+// Switching between 1D and 2D switches engines, so show is brought up to date
+// with the old and handed to the new.
+void cmd_twod(struct landscape *l, const struct sim_cmd *c)
+{
+	landscape_sync(l);
+	l->automata = twod_life_like;
+	landscape_touch(l);
+}
+
+void cmd_oned(struct landscape *l, const struct sim_cmd *c)
+{
+	sim.paused = 1;
+	landscape_sync(l);
+	l->rule = 110;
+	l->automata = oned;
+	l->quotient = clamped;
+	landscape_touch(l);
+}
+
+// Move the landscape's window on the plane by (x, y) cells. Other engines
+// have nowhere to go.
+static void plane_move(struct landscape *l, int64_t x, int64_t y)
+{
+	const struct engine *e = landscape_engine(l);
+
+	if (e->advance != plane_advance || !(x || y))
+		return;
+	if (l->engine_stale)
+		e->pack(l);
+	l->engine_stale = 0;
+
+	plane.x0 += x;
+	plane.y0 += y;
+	l->show_stale = 1;
+	mip.stale = 1;
+}
+
+// Scroll the view by (x, y) units. Past the edge of the landscape on the
+// plane, the landscape's window on the plane moves instead.
+void cmd_scroll(struct landscape *l, const struct sim_cmd *c)
+{
+	int64_t dx, dy;
+
+	sim.view.x0 += c->x * ((int64_t)1 << sim.view.block);
+	sim.view.y0 += c->y * ((int64_t)1 << sim.view.block);
+	view_clamp(l, &sim.view, &dx, &dy);
+	plane_move(l, dx, dy);
+}
+
+// Zoom in (arg 1) or out (arg -1) about the window pixel (x, y).
+void cmd_zoom(struct landscape *l, const struct sim_cmd *c)
+{
+	view_zoom(l, &sim.view, (int32_t)c->arg, c->x, c->y);
+}
+
+// The window is now x by y pixels.
+void cmd_resize(struct landscape *l, const struct sim_cmd *c)
+{
+	view_resize(l, &sim.view, c->x, c->y);
+}
+
+// Write the current generation to -o's file, or an RLE if none was given.
+void cmd_save(struct landscape *l, const struct sim_cmd *c)
+{
+	const char *path = l->output ? l->output : "cellularlandscapes.rle";
+	int ret = landscape_write(l, path);
+
+	if (ret < 0)
+		fprintf(stderr, "couldn't write %s: %s\n", path, strerror(-ret));
+	else
+		fprintf(stderr, "wrote %s\n", path);
+}
+
+// Called from the display thread only. If the simulation is so far behind
+// that the ring is full (deep in a leap, say) the command is dropped rather
+// than have the display wait.
+int sim_post(struct sim_cmd c)
+{
+	size_t head = atomic_load_explicit(&sim.head, memory_order_relaxed);
+
+	if (head - atomic_load_explicit(&sim.tail, memory_order_acquire) == SIM_CMDS) {
+		fprintf(stderr, "simulation busy, dropped a command\n");
+		return -1;
+	}
+	sim.cmds[head % SIM_CMDS] = c;
+	atomic_store_explicit(&sim.head, head + 1, memory_order_release);
+	eventfd_write(sim.wake, 1);
+	return 0;
+}
+
+static size_t sim_drain(struct landscape *l)
+{
+	size_t tail = atomic_load_explicit(&sim.tail, memory_order_relaxed);
+	size_t head = atomic_load_explicit(&sim.head, memory_order_acquire);
+
+	for (size_t i = tail; i != head; i++) {
+		const struct sim_cmd *c = &sim.cmds[i % SIM_CMDS];
+		c->apply(l, c);
+		// only looking doesn't change the cells
+		if (c->apply != cmd_zoom && c->apply != cmd_scroll
+				&& c->apply != cmd_resize && c->apply != cmd_pace)
+			mip.stale = 1;
+	}
+	atomic_store_explicit(&sim.tail, head, memory_order_release);
+	return head - tail;
+}
+
+// Draw the view into the back snapshot and swap it into the middle.
+static void sim_publish(struct landscape *l)
+{
+	struct snap *snap = &sim.snaps[sim.back];
+	uint64_t t = prof_now();
+
+	// a bigger window needs more units; each snapshot grows as it comes
+	// round, and if one can't, the window's left the size it was
+	size_t area = (size_t)sim.view.vw * sim.view.vh;
+	if (area > snap->size) {
+		uint8_t *looks = realloc(snap->looks, area);
+		if (looks) {
+			snap->looks = looks;
+			snap->size = area;
+		} else {
+			fprintf(stderr, "no mem for a %ux%u window\n",
+					sim.view.pw, sim.view.ph);
+			view_resize(l, &sim.view, snap->view.pw, snap->view.ph);
+		}
+	}
+
+	snap->view = sim.view;
+	snap->states = l->states > 2 ? l->states : 2;
+	view_looks(l, &snap->view, snap->looks);
+	sim.back = atomic_exchange(&sim.middle, sim.back | SNAP_FRESH) & ~SNAP_FRESH;
+	sim.dirty = 0;
+	prof_span(prof_publish, t);
+	eventfd_write(sim.ready, 1);
+}
+
+// The latest generation published. Display thread only; the snapshot stays
+// put until the next call.
+const struct snap *sim_snapshot(void)
+{
+	if (atomic_load(&sim.middle) & SNAP_FRESH)
+		sim.front = atomic_exchange(&sim.middle, sim.front) & ~SNAP_FRESH;
+	return &sim.snaps[sim.front];
+}
+
+// The simulation sleeps until there's a command, a tick of the pace's or,
+// flat out, not at all. Flat out it steps in batches of about a few ms, and
+// only draws a snapshot once the display's picked up the last.
+static void *sim_main(void *arg)
+{
+	struct landscape *l = arg;
+	struct pollfd pfd[] = {
+		{ .fd = sim.wake, .events = POLLIN },
+		{ .fd = sim.timer, .events = POLLIN },
+		{ .fd = sim.tick, .events = POLLIN },
+	};
+
+	while (!atomic_load(&sim.quit)) {
+		uint64_t n;
+
+		uint64_t t = prof_now();
+		if (sim_drain(l)) {
+			prof_span(prof_cmds, t);
+			sim.dirty = 1;
+		}
+		if (atomic_load(&sim.quit))
+			break;
+
+		int running = !sim.paused;
+		int flat_out = running && sim.pace == pace_free;
+		if (read(sim.timer, &n, sizeof(n)) == sizeof(n)
+				&& running && sim.pace == pace_rate) {
+			if (sim.rate <= 1000) {
+				sim.due += n;
+			} else {
+				sim.owed += n * sim.rate * sim_period();
+				sim.due += sim.owed / 1000000000;
+				sim.owed %= 1000000000;
+			}
+			// more than a second behind, the rate gives
+			if (sim.due > sim.rate)
+				sim.due = sim.rate;
+		}
+		// frames missed aren't made up
+		if (eventfd_read(sim.tick, &n) == 0
+				&& running && sim.pace == pace_frame)
+			sim.due = sim.per_frame;
+		if (flat_out)
+			sim.due = sim.batch;
+
+		if (running && sim.due) {
+			t = prof_now();
+			landscape_advance(l, sim.due);
+			prof_span(prof_step, t);
+			mip.stale = 1;
+			sim.dirty = 1;
+			sim.due = 0;
+
+			t = prof_now() - t;
+			if (flat_out && t < 2000000 && sim.batch < (uint64_t)1 << 40)
+				sim.batch *= 2;
+			else if (flat_out && t > 8000000 && sim.batch > 1)
+				sim.batch /= 2;
+		}
+
+		if (sim.dirty && !(flat_out
+				&& atomic_load(&sim.middle) & SNAP_FRESH))
+			sim_publish(l);
+
+		if (poll(pfd, 1 + 2 * !flat_out, flat_out ? 0 : -1) > 0
+				&& pfd[0].revents & POLLIN)
+			eventfd_read(sim.wake, &n);
+	}
+
+	return NULL;
+}
+
+// The display thread mustn't touch the landscape's state once this returns,
+// only its geometry.
+int sim_start(struct landscape *l)
+{
+	size_t area = (size_t)wl.view.pw * wl.view.ph; // units are a pixel or more
+
+	sim.wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	sim.ready = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	sim.tick = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	sim.timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (sim.wake < 0 || sim.ready < 0 || sim.tick < 0 || sim.timer < 0)
+		return -1;
+
+	for (int i = 0; i < 3; i++) {
+		if (!(sim.snaps[i].looks = calloc(area, 1)))
+			return -ENOMEM;
+		sim.snaps[i].size = area;
+		sim.snaps[i].view = wl.view;
+	}
+	sim.view = wl.view;
+	sim.back = 0;
+	sim.front = 1;
+	atomic_store(&sim.middle, 2);
+	sim.paused = wl.paused;
+	sim.pace = wl.pace;
+	sim.rate = wl.rate;
+	sim.per_frame = wl.per_frame;
+	sim.batch = 1;
+	sim_repace();
+
+	sim_publish(l);
+	if (pthread_create(&sim.thread, NULL, sim_main, l))
+		return -1;
+
+	return 0;
+}
+
+void sim_stop(void)
+{
+	atomic_store(&sim.quit, 1);
+	eventfd_write(sim.wake, 1);
+	pthread_join(sim.thread, NULL);
+}
+
+void highlight_cell(struct landscape *landscape,
+		uint32_t *pixels, int x, int y)
+{
+	size_t X, Y;
+	landscape_fold(landscape, x, y, &X, &Y);
+
+	size_t tl = landscape->cell_width;
+	size_t w = landscape->width * tl; // pixels per row
+	for (size_t xx = x*tl; xx < (X + 1)*tl; xx++)
+		for (size_t yy = Y * tl * w; yy < (Y + 1) * tl * w; yy += w)
+			pixels[yy + xx] ^= 0x00000000;
+}
+
+void highlight_neighbourhood(struct landscape *ls, uint32_t *pixels, int x, int y)
+{
+	highlight_cell(ls, pixels, x - 1, y - 1);
+	highlight_cell(ls, pixels, x    , y - 1);
+	highlight_cell(ls, pixels, x + 1, y - 1);
+	highlight_cell(ls, pixels, x - 1, y);
+	highlight_cell(ls, pixels, x    , y);
+	highlight_cell(ls, pixels, x + 1, y);
+	highlight_cell(ls, pixels, x - 1, y + 1);
+	highlight_cell(ls, pixels, x    , y + 1);
+	highlight_cell(ls, pixels, x + 1, y + 1);
+}
+
+// A raster row kernel expands n cell states into the n*cw pixels of one
+// scanline; the rest of the cells' rows are copies of it.
+typedef void (*raster_row_fn)(uint32_t *out, const uint8_t *state, size_t n,
+		size_t cw);
+
+static void raster_row_scalar(uint32_t *out, const uint8_t *state, size_t n,
+		size_t cw)
+{
+	for (size_t x = 0; x < n; x++)
+		for (size_t i = 0; i < cw; i++)
+			*out++ = state_colours[state[x]];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// state_colours split into byte planes, so a byte shuffle looks up one byte
+// of sixteen colours at once; two halves of a plane make the LOOKS_MAX.
+static uint8_t raster_planes[4][2][16] __attribute__((aligned(16)));
+
+static void raster_planes_compile(void)
+{
+	for (size_t i = 0; i < LOOKS_MAX; i++)
+		for (int b = 0; b < 4; b++)
+			raster_planes[b][i / 16][i % 16] = state_colours[i] >> 8*b;
+}
+
+// A shuffle gives 0 where the index has its top bit set. Saturating 0x70
+// onto a look sets it for 16 and up and leaves the low nibble alone below,
+// and taking 16 sets it for the rest, so each half answers for its own.
+__attribute__((target("ssse3")))
+static inline __m128i raster_plane_ssse3(const uint8_t plane[2][16],
+		__m128i lo, __m128i hi)
+{
+	return _mm_or_si128(
+		_mm_shuffle_epi8(_mm_load_si128((const __m128i *)plane[0]), lo),
+		_mm_shuffle_epi8(_mm_load_si128((const __m128i *)plane[1]), hi));
+}
+
+__attribute__((target("ssse3")))
+static void raster_row_ssse3(uint32_t *out, const uint8_t *state, size_t n,
+		size_t cw)
+{
+	size_t x = 0;
+
+	for (; x + 16 <= n; x += 16) {
+		__m128i s = _mm_loadu_si128((const __m128i *)(state + x));
+		__m128i lo = _mm_adds_epu8(s, _mm_set1_epi8(0x70));
+		__m128i hi = _mm_sub_epi8(s, _mm_set1_epi8(16));
+		__m128i b0 = raster_plane_ssse3(raster_planes[0], lo, hi);
+		__m128i b1 = raster_plane_ssse3(raster_planes[1], lo, hi);
+		__m128i b2 = raster_plane_ssse3(raster_planes[2], lo, hi);
+		__m128i b3 = raster_plane_ssse3(raster_planes[3], lo, hi);
+		__m128i lo01 = _mm_unpacklo_epi8(b0, b1), hi01 = _mm_unpackhi_epi8(b0, b1);
+		__m128i lo23 = _mm_unpacklo_epi8(b2, b3), hi23 = _mm_unpackhi_epi8(b2, b3);
+		__m128i px[4] = {
+			_mm_unpacklo_epi16(lo01, lo23), _mm_unpackhi_epi16(lo01, lo23),
+			_mm_unpacklo_epi16(hi01, hi23), _mm_unpackhi_epi16(hi01, hi23),
+		};
+
+		for (int i = 0; i < 4; i++) {
+			if (cw == 1) {
+				_mm_storeu_si128((__m128i *)out, px[i]);
+				out += 4;
+			} else if (cw == 2) {
+				_mm_storeu_si128((__m128i *)out,
+						_mm_unpacklo_epi32(px[i], px[i]));
+				_mm_storeu_si128((__m128i *)(out + 4),
+						_mm_unpackhi_epi32(px[i], px[i]));
+				out += 8;
+			} else {
+				uint32_t c[4];
+				_mm_storeu_si128((__m128i *)c, px[i]);
+				for (int j = 0; j < 4; j++) {
+					__m128i v = _mm_set1_epi32(c[j]);
+					size_t k = 0;
+					for (; k + 4 <= cw; k += 4)
+						_mm_storeu_si128((__m128i *)(out + k), v);
+					for (; k < cw; k++)
+						out[k] = c[j];
+					out += cw;
+				}
+			}
+		}
+	}
+	raster_row_scalar(out, state + x, n - x, cw);
+}
+#endif
+
+raster_row_fn raster_row = raster_row_scalar;
+
+// The colours for cells of `states` states: look_colours, with the dying of a
+// Generations rule fading from amber to a dull red however many there are.
+// The rows look their colours up, so there's no telling states apart per
+// cell.
+void palette_compile(uint32_t states)
+{
+	static const int from[3] = { 0xff, 0xb0, 0x20 }, to[3] = { 0x50, 0x10, 0x18 };
+
+	memcpy(state_colours, look_colours, sizeof(look_colours));
+	for (uint32_t s = 2; s < states && s < STATES_MAX; s++) {
+		int t = states > 3 ? (s - 2) * 256 / (states - 3) : 0;
+		uint32_t c = 0x80000000;
+		for (int i = 0; i < 3; i++)
+			c |= (uint32_t)(from[i] + (to[i] - from[i]) * t / 256)
+				<< 8 * (2 - i);
+		state_colours[s] = c;
+	}
+#if defined(__x86_64__) || defined(__i386__)
+	raster_planes_compile();
+#endif
+}
+
+void raster_row_select(void)
+{
+	palette_compile(2);
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("ssse3"))
+		raster_row = raster_row_ssse3;
+#endif
+}
+
+// Paints units [x0, x1) of row y from states, which are how they look. The
+// last column and row of units may hang off the window.
+static void raster_cells(const struct view *v, uint32_t *pixels,
+		const uint8_t *states, size_t x0, size_t x1, size_t y)
+{
+	size_t w = v->pw; // pixels per row
+	uint32_t *line = pixels + y * v->ch * w + x0 * v->cw;
+	size_t n = (x1 - x0) * v->cw, rows = v->ch;
+
+	if (x0 * v->cw + n > w) {
+		size_t full = (w - x0 * v->cw) / v->cw;
+		raster_row(line, states + x0, full, v->cw);
+		n = w - x0 * v->cw;
+		for (size_t i = full * v->cw; i < n; i++)
+			line[i] = state_colours[states[x0 + full]];
+	} else {
+		raster_row(line, states + x0, x1 - x0, v->cw);
+	}
+	if ((y + 1) * v->ch > v->ph)
+		rows = v->ph - y * v->ch;
+	for (size_t i = 1; i < rows; i++)
+		memcpy(line + i*w, line, n * 4);
+}
+
+// From x, the first cell of [x, n) where a and b differ, or with `agree`,
+// where they're the same; eight at a time while there's nothing to see.
+static size_t cells_scan(const uint8_t *a, const uint8_t *b, size_t x,
+		size_t n, int agree)
+{
+	const uint64_t ones = 0x0101010101010101, highs = ones << 7;
+
+	for (; x + 8 <= n; x += 8) {
+		uint64_t u, v, d;
+		memcpy(&u, a + x, 8);
+		memcpy(&v, b + x, 8);
+		d = u ^ v;
+		// any zero byte of d is a cell that agrees
+		if (agree ? (d - ones) & ~d & highs : d)
+			break;
+	}
+	while (x < n && (a[x] == b[x]) != agree)
+		x++;
+	return x;
+}
+
+// Adds units [x0, x1) of row y to wl.damage, growing a rect from the row
+// above when the span lines up with it.
+static void landscape_damage(const struct view *v, size_t x0, size_t x1,
+		size_t y)
+{
+	int32_t x = x0 * v->cw, w = (x1 - x0) * v->cw;
+	int32_t top = y * v->ch, h = v->ch;
+
+	if (x + w > (int32_t)v->pw)
+		w = v->pw - x;
+	if (top + h > (int32_t)v->ph)
+		h = v->ph - top;
+
+	if (wl.ndamage > DAMAGE_MAX)
+		return;
+
+	for (size_t i = 0; i < wl.ndamage; i++) {
+		if (wl.damage[i].x == x && wl.damage[i].w == w
+				&& wl.damage[i].y + wl.damage[i].h == top) {
+			wl.damage[i].h += h;
+			return;
+		}
+	}
+
+	if (wl.ndamage == DAMAGE_MAX) {
+		wl.ndamage++;
+		return;
+	}
+	wl.damage[wl.ndamage++] = (struct rect){ x, top, w, h };
+}
+
+static int view_same_units(const struct view *a, const struct view *b)
+{
+	return a->cw == b->cw && a->ch == b->ch && a->vw == b->vw && a->vh == b->vh;
+}
+
+// Only the units that differ from what the buffer last held are painted, but
+// the damage is against what's on screen, i.e. the front buffer; the two
+// differ whenever the buffers alternate. A zoom moves every unit, so
+// everything is painted and damaged; a scroll only changes what's in them.
+void landscape_draw(struct landscape *l, const struct snap *snap,
+		struct buffer *buffer)
+{
+	const struct view *v = &snap->view;
+	size_t w = v->vw, cx = SIZE_MAX, cy = SIZE_MAX;
+	uint8_t *front;
+
+	// a new palette changes what every unit looks like
+	if (snap->states != wl.states) {
+		palette_compile(snap->states);
+		wl.states = snap->states;
+		for (size_t i = 0; i < wl.nbuffers; i++)
+			wl.buffers[i].view.vw = 0;
+	}
+	front = wl.front && view_same_units(&wl.front->view, v)
+		? wl.front->cells : NULL;
+
+	if (!view_same_units(&buffer->view, v))
+		memset(buffer->cells, 0xff, w * v->vh);
+	buffer->view = *v;
+	wl.view = *v;
+
+	if (w > wl.look_w) {
+		uint8_t *look = realloc(wl.look, w);
+		if (look) {
+			wl.look = look;
+			wl.look_w = w;
+		}
+	}
+
+	if (wl.pointer_cell >= 0 && w <= wl.look_w) {
+		int64_t ux = (wl.pointer_cell % l->width - v->x0) >> v->block;
+		int64_t uy = (wl.pointer_cell / l->width - v->y0) >> v->block;
+		if (ux >= 0 && ux < v->vw && uy >= 0 && uy < v->vh)
+			cx = ux, cy = uy;
+	}
+
+	wl.ndamage = front ? 0 : DAMAGE_MAX + 1;
+	for (size_t y = 0; y < v->vh; y++) {
+		const uint8_t *look = snap->looks + y*w;
+		uint8_t *seen = buffer->cells + y*w;
+
+		if (y == cy) {
+			memcpy(wl.look, look, w);
+			wl.look[cx] = cell_cursor;
+			look = wl.look;
+		}
+
+		if (wl.ndamage <= DAMAGE_MAX) {
+			uint8_t *shown = front + y*w;
+			for (size_t x0 = cells_scan(look, shown, 0, w, 0), x1; x0 < w;
+					x0 = cells_scan(look, shown, x1, w, 0)) {
+				x1 = cells_scan(look, shown, x0, w, 1);
+				landscape_damage(v, x0, x1, y);
+			}
+		}
+
+		for (size_t x0 = cells_scan(look, seen, 0, w, 0), x1; x0 < w;
+				x0 = cells_scan(look, seen, x1, w, 0)) {
+			x1 = cells_scan(look, seen, x0, w, 1);
+			memcpy(seen + x0, look + x0, x1 - x0);
+			raster_cells(v, buffer->pixels, look, x0, x1, y);
+		}
+	}
+}
+
+void bind_globals(void *data, struct wl_registry *r, uint32_t name,
+		const char *interface, uint32_t version)
+{
+	if (strcmp(interface, wl_compositor_interface.name) == 0) {
+		wl.compositor = wl_registry_bind(r, name,
+				&wl_compositor_interface, 4);
+	} else if (strcmp(interface, wl_shm_interface.name) == 0) {
+		wl.shm = wl_registry_bind(r, name, &wl_shm_interface, 1);
+	} else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+		wl.wm = wl_registry_bind(r, name, &xdg_wm_base_interface, 1);
+	} else if (strcmp(interface, wl_seat_interface.name) == 0) {
+		wl.seat = wl_registry_bind(r, name, &wl_seat_interface, 4);
+	}
+}
+
+void registry_remove(void *d, struct wl_registry *r, uint32_t n) { }
+
+static const struct wl_registry_listener registry_listener = {
+	.global = bind_globals,
+	.global_remove = registry_remove,
+};
+
+static void xdg_wm_base_ping(void *data, struct xdg_wm_base *wm, uint32_t serial)
+{
+	xdg_wm_base_pong(wm, serial);
+}
+
+struct wl_callback_listener frame_listener = {
+	.done = frame_listener_done,
+};
+
+// A size of 0 leaves it to us, so the window stays as it is.
+static void xdg_top_config(void *data, struct xdg_toplevel *top,
+		int32_t width, int32_t height, struct wl_array *states)
+{
+	wl.config_w = width;
+	wl.config_h = height;
+}
+
+static void xdg_top_close(void *data, struct xdg_toplevel *top)
+{
+	wl.running = 0;
+}
+
+static const struct xdg_toplevel_listener xdg_top_listener = {
+	.configure = xdg_top_config,
+	.close = xdg_top_close,
+};
+
+// The new size takes once the simulation has published a view that big;
+// until then the old one is drawn, which the compositor takes as it is.
+static void xdg_surf_config(void *data, struct xdg_surface *surf, uint32_t serial)
+{
+	xdg_surface_ack_configure(wl.xdg_surf, serial);
+
+	int32_t w = wl.config_w ? wl.config_w : wl.want_w;
+	int32_t h = wl.config_h ? wl.config_h : wl.want_h;
+	if (w != wl.want_w || h != wl.want_h) {
+		if (sim_post((struct sim_cmd){
+				.apply = cmd_resize, .x = w, .y = h }) == 0) {
+			wl.want_w = w;
+			wl.want_h = h;
+		}
+	}
+
+	if (wl.wait_for_config) {
+		wl.wait_for_config = 0;
+		render(data);
+	}
+}
+
+static const struct xdg_surface_listener xdg_surf_listener = {
+	.configure = xdg_surf_config,
+};
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+	.ping = xdg_wm_base_ping,
+};
+
+void pointer_enter(void *data, struct wl_pointer *p, uint32_t serial, struct wl_surface *s,
+		wl_fixed_t x, wl_fixed_t y)
+{
+	struct landscape *b = data;
+
+	wl.pointer_x = wl_fixed_to_int(x);
+	wl.pointer_y = wl_fixed_to_int(y);
+	int64_t tmp = view_cell(b, &wl.view, wl.pointer_x, wl.pointer_y);
+	if (tmp < 0)
+		return;
+	wl.pointer_cell = tmp;
+
+	wl.redraw = 1;
+}
+
+void pointer_motion(void *data, struct wl_pointer *p, uint32_t time,
+		wl_fixed_t x, wl_fixed_t y)
+{
+	struct landscape *l;
+	int64_t tmp;
+
+	l = data;
+	wl.pointer_x = wl_fixed_to_int(x);
+	wl.pointer_y = wl_fixed_to_int(y);
+	tmp = view_cell(l, &wl.view, wl.pointer_x, wl.pointer_y);
+
+	if (tmp < 0)
+		return;
+	wl.pointer_cell = tmp;
+
+	if (wl.pointer_held && wl.brush == brush_rule)
+		sim_post((struct sim_cmd){ .apply = cmd_brush, .brush = wl.brush,
+			.x = tmp % l->width, .y = tmp / l->width });
+	else if (wl.pointer_held == BTN_LEFT || wl.pointer_held == BTN_RIGHT)
+		sim_post((struct sim_cmd){ .apply = cmd_paint,
+			.x = tmp % l->width, .y = tmp / l->width,
+			.arg = wl.pointer_held == BTN_LEFT ? cell_on : cell_off });
+
+	wl.redraw = 1;
+}
+
+void pointer_leave(void *d, struct wl_pointer *p, uint32_t serial, struct wl_surface *s)
+{
+}
+
+void pointer_button(void *d, struct wl_pointer *p, uint32_t serial, uint32_t time,
+		uint32_t button, uint32_t state)
+{
+	struct landscape *l = d;
+
+	if (state == WL_POINTER_BUTTON_STATE_PRESSED)
+		wl.pointer_held = button;
+	else if (state == WL_POINTER_BUTTON_STATE_RELEASED)
+		wl.pointer_held = 0;
+
+
+	if (wl.pointer_cell >= 0 && wl.pointer_held == 0)
+		// draw on release
+		sim_post((struct sim_cmd){ .apply = cmd_brush, .brush = wl.brush,
+			.x = wl.pointer_cell % l->width,
+			.y = wl.pointer_cell / l->width });
+
+	wl.redraw = 1;
+}
+
+// Scrolling zooms about the pointer; scrolling sideways pans. A notch of a
+// wheel is 10.
+void pointer_axis(void *d, struct wl_pointer *p, uint32_t time, uint32_t axis,
+		wl_fixed_t value)
+{
+	double *a = &wl.axis[axis == WL_POINTER_AXIS_HORIZONTAL_SCROLL];
+
+	for (*a += wl_fixed_to_double(value); *a <= -10 || *a >= 10; ) {
+		int dir = *a < 0 ? -1 : 1;
+		*a -= 10 * dir;
+		if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL)
+			sim_post((struct sim_cmd){ .apply = cmd_zoom, .arg = -dir,
+				.x = wl.pointer_x, .y = wl.pointer_y });
+		else
+			sim_post((struct sim_cmd){ .apply = cmd_scroll,
+				.x = dir * (int32_t)(wl.view.vw / 8 + 1) });
+	}
+}
+
+void pointer_frame(void *d, struct wl_pointer *p)
+{
+}
+
+void pointer_axis_source(void *d, struct wl_pointer *p, uint32_t a)
+{
+}
+
+void pointer_axis_stop(void *d, struct wl_pointer *p, uint32_t t, uint32_t a)
+{
+}
+
+void pointer_axis_discrete(void *d, struct wl_pointer *p, uint32_t a, int32_t discrete)
+{
+}
+
+struct wl_pointer_listener wl_pointer_listener = {
+	.enter          = pointer_enter,
+	.leave          = pointer_leave,
+	.motion         = pointer_motion,
+	.button         = pointer_button,
+	.axis           = pointer_axis,
+	.frame          = pointer_frame,
+	.axis_source    = pointer_axis_source,
+	.axis_stop      = pointer_axis_stop,
+	.axis_discrete  = pointer_axis_discrete,
+};
+
+void seat_name(void *data, struct wl_seat *seat, const char *name)
+{
+}
+
+static void keyboard_handle_keymap(void *data, struct wl_keyboard *keyboard, uint32_t format, int fd, uint32_t size)
+{
+	close(fd);
+}
+
+static void keyboard_handle_enter(void *data, struct wl_keyboard *keyboard, uint32_t serial, struct wl_surface *surface, struct wl_array *keys)
+{
+}
+
+static void keyboard_handle_leave(void *data, struct wl_keyboard *keyboard, uint32_t serial, struct wl_surface *surface)
+{
+	wl.repeat_key = 0;
+	timerfd_settime(wl.repeat, 0, &(struct itimerspec){0}, NULL);
+}
+
+
+static void keyboard_handle_modifiers(void *data, struct wl_keyboard *keyboard, uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group)
+{
+}
+
+static void pace_post(void)
+{
+	static const char *names[] = {
+		[pace_rate] = "generations/s",
+		[pace_frame] = "generations/frame",
+		[pace_free] = "flat out",
+	};
+
+	if (wl.pace == pace_rate)
+		fprintf(stderr, "pace: %u %s\n", wl.rate, names[wl.pace]);
+	else if (wl.pace == pace_frame)
+		fprintf(stderr, "pace: %u %s\n", wl.per_frame, names[wl.pace]);
+	else
+		fprintf(stderr, "pace: %s\n", names[wl.pace]);
+	sim_post((struct sim_cmd){ .apply = cmd_pace, .arg = wl.pace,
+			.x = wl.rate, .y = wl.per_frame });
+}
+
+static void key_press(struct landscape *ls, uint32_t key, uint32_t state)
+{
+	int x = wl.pointer_cell % ls->width, y = wl.pointer_cell / ls->width;
+
+	if (key == KEY_R && state) {
+		wl.paused = 1;
+		sim_post((struct sim_cmd){ .apply = cmd_reset });
+	}
+
+	if (key == KEY_P && state && wl.pointer_cell >= 0)
+		sim_post((struct sim_cmd){ .apply = cmd_toggle, .x = x, .y = y });
+
+	// with the rule brush, C, + and - change its ink
+	if (key == KEY_G && state) {
+		if (wl.brush == brush_default)
+			wl.brush = brush_conway_glider;
+		else if (wl.brush == brush_conway_glider)
+			wl.brush = brush_rule;
+		else
+			wl.brush = brush_default;
+	}
+	int ink = wl.brush == brush_rule;
+
+	if (key == KEY_J && state) {
+		wl.pointer_cell += ls->width;
+		wl.pointer_cell %= ls->width * ls->height;
+	}
+
+	if (key == KEY_K && state) {
+		wl.pointer_cell -= ls->width - ls->width * ls->height;
+		wl.pointer_cell %= ls->width * ls->height;
+	}
+
+	if (key == KEY_H && state) {
+		wl.pointer_cell--;
+	}
+
+
+	if (key == KEY_L && state) {
+		wl.pointer_cell++;
+	}
+
+	if (key == KEY_SPACE && state) {
+		wl.paused = !wl.paused;
+		sim_post((struct sim_cmd){ .apply = cmd_pause, .arg = wl.paused });
+	}
+
+	if (key == KEY_D && state && wl.pointer_cell >= 0)
+		sim_post((struct sim_cmd){ .apply = cmd_debug, .x = x, .y = y });
+
+	if (key == KEY_N && state && wl.paused)
+		sim_post((struct sim_cmd){ .apply = cmd_step });
+
+	if (key == KEY_F && state)
+		sim_post((struct sim_cmd){ .apply = cmd_step, .arg = wl.leap });
+
+	if (key == KEY_LEFTBRACE && state && wl.leap > 0)
+		fprintf(stderr, "leap: 2^%u\n", --wl.leap);
+
+	if (key == KEY_RIGHTBRACE && state && wl.leap < 62)
+		fprintf(stderr, "leap: 2^%u\n", ++wl.leap);
+
+	// a quarter of the window at a time
+	int32_t qw = wl.view.vw / 4 + 1, qh = wl.view.vh / 4 + 1;
+	if (key == KEY_LEFT && state)
+		sim_post((struct sim_cmd){ .apply = cmd_scroll, .x = -qw });
+	if (key == KEY_RIGHT && state)
+		sim_post((struct sim_cmd){ .apply = cmd_scroll, .x = qw });
+	if (key == KEY_UP && state)
+		sim_post((struct sim_cmd){ .apply = cmd_scroll, .y = -qh });
+	if (key == KEY_DOWN && state)
+		sim_post((struct sim_cmd){ .apply = cmd_scroll, .y = qh });
+
+	// about the middle of the window
+	if ((key == KEY_Z || key == KEY_X) && state)
+		sim_post((struct sim_cmd){ .apply = cmd_zoom,
+			.arg = key == KEY_Z ? 1 : -1,
+			.x = wl.view.pw / 2, .y = wl.view.ph / 2 });
+
+	if (key == KEY_I && state) {
+		prof.hud = !prof.hud;
+		prof_report();
+		wl.redraw = 1;
+	}
+
+	if (key == KEY_W && state)
+		sim_post((struct sim_cmd){ .apply = cmd_save });
+
+	if (key == KEY_ESC && state)
+		wl.running = 0;
+
+	if (key == KEY_C && state)
+		sim_post((struct sim_cmd){ .apply = cmd_rule, .arg = conway,
+				.x = ink });
+
+	if (key == KEY_2 && state)
+		sim_post((struct sim_cmd){ .apply = cmd_twod });
+
+	if (key == KEY_1 && state) {
+		wl.paused = 1;
+		sim_post((struct sim_cmd){ .apply = cmd_oned });
+	}
+
+	if (key == KEY_EQUAL && state)
+		sim_post((struct sim_cmd){ .apply = cmd_rule_add, .arg = 1,
+				.x = ink });
+	if (key == KEY_MINUS && state)
+		sim_post((struct sim_cmd){ .apply = cmd_rule_add, .arg = -1,
+				.x = ink });
+
+	// 9 and 0 take sixteenths off and on the chance a cell steps
+	if ((key == KEY_9 || key == KEY_0) && state)
+		sim_post((struct sim_cmd){ .apply = cmd_alpha_add,
+				.arg = key == KEY_0 ? 16 : -16 });
+
+	// V goes through the paces; , and . halve and double the one it's at
+	if (key == KEY_V && state) {
+		wl.pace = (wl.pace + 1) % (pace_free + 1);
+		pace_post();
+	}
+	if ((key == KEY_COMMA || key == KEY_DOT) && state && wl.pace != pace_free) {
+		uint32_t *v = wl.pace == pace_rate ? &wl.rate : &wl.per_frame;
+		if (key == KEY_DOT && *v < 1u << 30)
+			*v *= 2;
+		else if (key == KEY_COMMA && *v > 1)
+			*v /= 2;
+		pace_post();
+	}
+}
+
+// Only keys that do a bit more each time are worth holding down.
+static int key_repeats(uint32_t key)
+{
+	switch (key) {
+	case KEY_EQUAL: case KEY_MINUS: case KEY_9: case KEY_0:
+	case KEY_COMMA: case KEY_DOT:
+	case KEY_LEFTBRACE: case KEY_RIGHTBRACE:
+	case KEY_LEFT: case KEY_RIGHT: case KEY_UP: case KEY_DOWN:
+	case KEY_H: case KEY_J: case KEY_K: case KEY_L:
+	case KEY_N: case KEY_Z: case KEY_X:
+		return 1;
+	}
+	return 0;
+}
+
+static void keyboard_handle_key(void *data, struct wl_keyboard *keyboard,
+		    uint32_t serial, uint32_t time, uint32_t key,
+		    uint32_t state)
+{
+	struct itimerspec its = {0};
+
+	if (state && key_repeats(key) && wl.repeat_rate > 0) {
+		its.it_value.tv_sec = wl.repeat_delay / 1000;
+		its.it_value.tv_nsec = wl.repeat_delay % 1000 * 1000000;
+		its.it_interval.tv_nsec = 1000000000 / wl.repeat_rate;
+		if (wl.repeat_rate == 1)
+			its.it_interval = (struct timespec){ .tv_sec = 1 };
+		wl.repeat_key = key;
+		timerfd_settime(wl.repeat, 0, &its, NULL);
+	} else if (state || key == wl.repeat_key) {
+		wl.repeat_key = 0;
+		timerfd_settime(wl.repeat, 0, &its, NULL);
+	}
+
+	key_press(data, key, state);
+}
+
+// The held key, again for each time the timer went off, bar any backlog.
+void keyboard_repeat(struct landscape *l)
+{
+	uint64_t n;
+
+	if (read(wl.repeat, &n, sizeof(n)) == sizeof(n) && wl.repeat_key)
+		key_press(l, wl.repeat_key, WL_KEYBOARD_KEY_STATE_PRESSED);
+}
+
+static void keyboard_handle_repeat(void *data, struct wl_keyboard *k,
+		int32_t rate, int32_t delay)
+{
+	wl.repeat_rate = rate;
+	wl.repeat_delay = delay;
+}
+
+static const struct wl_keyboard_listener keyboard_listener = {
+	.keymap = keyboard_handle_keymap,
+	.enter = keyboard_handle_enter,
+	.leave = keyboard_handle_leave,
+	.key = keyboard_handle_key,
+	.modifiers = keyboard_handle_modifiers,
+	.repeat_info = keyboard_handle_repeat,
+};
+
+void seat_handle_caps(void *data, struct wl_seat *seat, uint32_t caps)
+{
+	if ((caps & WL_SEAT_CAPABILITY_POINTER) && !wl.pointer) {
+		wl.pointer = wl_seat_get_pointer(wl.seat);
+		wl_pointer_add_listener(wl.pointer, &wl_pointer_listener, data);
+	} else if ((caps & WL_SEAT_CAPABILITY_POINTER) && wl.pointer) {
+		wl_pointer_destroy(wl.pointer);
+		wl.pointer = NULL;
+	}
+
+	if ((caps & WL_SEAT_CAPABILITY_KEYBOARD) && !wl.keyboard) {
+		wl.keyboard = wl_seat_get_keyboard(seat);
+		wl_keyboard_add_listener(wl.keyboard, &keyboard_listener, data);
+	} else if (!(caps & WL_SEAT_CAPABILITY_KEYBOARD) && wl.keyboard) {
+		wl_keyboard_destroy(wl.keyboard);
+		wl.keyboard = NULL;
+	}
+}
+
+static const struct wl_seat_listener wl_seat_listener = {
+	.capabilities = seat_handle_caps,
+	.name = seat_name,
+};
+
+// The HUD: a strip for each of step, draw and frame times, one column per
+// span, newest on the right. Heights are log2 of the time, 1us at the
+// bottom to 64ms at the top; the grey line is 16.7ms. The units under it are
+// marked unseen in the buffer, so they are repainted, and damaged, whenever
+// the HUD moves or goes away.
+#define HUD_BARS 128
+#define HUD_STRIP 32 // [px]
+
+static void prof_hud(struct buffer *buffer)
+{
+	static const enum prof_kind strips[] = { prof_step, prof_draw, prof_frame };
+	static const uint32_t colours[] = { 0xffffd000, 0xffff4040, 0xff40a0ff };
+	const struct view *v = &buffer->view;
+	size_t bw = v->pw;
+	size_t cw = (2 * HUD_BARS + v->cw - 1) / v->cw;
+	size_t ch = (3 * (HUD_STRIP + 2) + v->ch - 1) / v->ch;
+
+	if (cw > v->vw)
+		cw = v->vw;
+	if (ch > v->vh)
+		ch = v->vh;
+	size_t pw = cw * v->cw, ph = ch * v->ch;
+	if (pw > v->pw)
+		pw = v->pw;
+	if (ph > v->ph)
+		ph = v->ph;
+
+	for (size_t y = 0; y < ph; y++)
+		for (size_t x = 0; x < pw; x++)
+			buffer->pixels[y * bw + x] = 0xe0000000;
+
+	for (size_t s = 0; s < 3; s++) {
+		uint64_t d[HUD_BARS];
+		size_t n = prof_latest(strips[s], d, HUD_BARS);
+		size_t base = (s + 1) * (HUD_STRIP + 2); // bottom of the strip
+
+		for (size_t i = 0; i < n; i++) {
+			size_t x = 2 * (HUD_BARS - 1 - i);
+			size_t h = 0;
+			for (uint64_t us = d[i] / 1000; us && h < HUD_STRIP; us >>= 1)
+				h += 2;
+
+			for (size_t y = base - h; y < base; y++)
+				for (size_t dx = 0; dx < 2; dx++)
+					if (y < ph && x + dx < pw)
+						buffer->pixels[y * bw + x + dx] = colours[s];
+		}
+		size_t mark = base - 28; // log2(16700) ~ 14
+		if (mark < ph)
+			for (size_t x = 0; x < pw; x += 2)
+				buffer->pixels[mark * bw + x] = 0xff808080;
+	}
+
+	for (size_t y = 0; y < ch; y++) {
+		memset(buffer->cells + y * v->vw, 0xff, cw);
+		landscape_damage(v, 0, cw, y);
+	}
+}
+
+void render(void *data) {
+	struct landscape *landscape = data;
+	const struct snap *snap = sim_snapshot();
+	struct buffer *buf = landscape_next_buffer(&snap->view);
+	if (!buf) {
+		// redraw stays set, so the frame is drawn as soon as a buffer
+		// is released
+		if (!prof.stall)
+			prof.stall = prof_now();
+		return;
+	}
+	if (prof.stall) {
+		prof_span(prof_stall, prof.stall);
+		prof.stall = 0;
+	}
+
+	uint64_t t = prof_now();
+	landscape_draw(landscape, snap, buf);
+	if (prof.hud)
+		prof_hud(buf);
+	prof_span(prof_draw, t);
+	if (!wl.ndamage) {
+		// nothing on screen would change, but paced by frames the
+		// simulation still wants to hear of the next one
+		wl.redraw = 0;
+		if (wl.pace == pace_frame && !wl.paused) {
+			wl.frame_cb = wl_surface_frame(wl.surf);
+			wl_callback_add_listener(wl.frame_cb, &frame_listener,
+					landscape);
+			wl_surface_commit(wl.surf);
+		}
+		return;
+	}
+
+	wl_surface_attach(wl.surf, buf->wl_buffer, 0, 0);
+	if (wl.ndamage > DAMAGE_MAX)
+		wl_surface_damage_buffer(wl.surf, 0, 0, INT32_MAX, INT32_MAX);
+	else for (size_t i = 0; i < wl.ndamage; i++)
+		wl_surface_damage_buffer(wl.surf, wl.damage[i].x, wl.damage[i].y,
+				wl.damage[i].w, wl.damage[i].h);
+	wl.front = buf;
+	wl.frame_cb = wl_surface_frame(wl.surf);
+	wl_callback_add_listener(wl.frame_cb, &frame_listener, landscape);
+
+	t = prof_now();
+	wl_surface_commit(wl.surf);
+	prof.commit = prof_now();
+	prof_span(prof_commit, t);
+
+	wl.redraw = 0;
+	buf->busy = 1;
+}
+
+// At most one frame is drawn per frame shown; what comes in meanwhile waits
+// for this.
+void frame_listener_done(void *data, struct wl_callback *callback, uint32_t time) {
+	wl_callback_destroy(callback);
+	wl.frame_cb = NULL;
+	if (prof.commit)
+		prof_span(prof_frame, prof.commit);
+	prof.commit = 0;
+	if (wl.pace == pace_frame && !wl.paused)
+		eventfd_write(sim.tick, 1);
+	if (wl.redraw)
+		render(data);
+}
+
+
+int check_registry(void)
+{
+	int ret = 0;
+
+	if (!wl.compositor)
+		fprintf(stderr, "missing compositor\n"), ret++;
+	if (!wl.shm)
+		fprintf(stderr, "missing shm\n"), ret++;
+	if (!wl.wm)
+		fprintf(stderr, "missing xdg_wm_base\n"), ret++;
+	if (!wl.seat)
+		fprintf(stderr, "missing seat\n"), ret++;
+
+	return ret;
+}
+
+void brush_default(struct landscape *landscape, int x, int y)
+{
+	size_t X, Y;
+
+	landscape_fold(landscape, x, y, &X, &Y);
+	landscape_set_front(landscape, X, Y, 1);
+}
+
+// The tile under (x, y) steps by the ink from now on.
+void brush_rule(struct landscape *landscape, int x, int y)
+{
+	size_t X, Y;
+
+	landscape_fold(landscape, x, y, &X, &Y);
+	int ret = landscape_paint_rule(landscape, X, Y, 1, 1, landscape->ink);
+	if (ret == -ENOTSUP)
+		fprintf(stderr, "couldn't paint the rule: Larger than Life has one\n");
+	else if (ret < 0)
+		fprintf(stderr, "couldn't paint the rule: the palette's full\n");
+}
+
+void brush_conway_glider(struct landscape *landscape, int x, int y)
+{
+	size_t X, Y;
+
+	landscape_fold(landscape, x, y, &X, &Y);
+
+	landscape_set_front(landscape, X-1, Y+1, 1);
+	landscape_set_front(landscape, X,   Y-1, 1);
+	landscape_set_front(landscape, X,   Y+1, 1);
+	landscape_set_front(landscape, X+1, Y  , 1);
+	landscape_set_front(landscape, X+1, Y+1, 1);
+}
+
+int landscape_init_memory(struct landscape *landscape)
+{
+	// first, as an engine may bring its own geometry
+	if (landscape->engine->init && landscape->engine->init(landscape) < 0) {
+		fprintf(stderr, "couldn't start the %s engine\n",
+				landscape->engine->name);
+		return -ENOMEM;
+	}
+
+	landscape->stride = landscape->width + 2;
+	size_t area = landscape->stride * (landscape->height + 2);
+
+	landscape->flip = landscape_alloc(area);
+	landscape->flop = landscape_alloc(area);
+	if (!(landscape->flip && landscape->flop)) {
+		fprintf(stderr, "no mem\n");
+		return -ENOMEM;
+	}
+	landscape->show = landscape->flip;
+
+	// the automata can be switched to 1D at any time
+	if (oned_init(landscape) < 0) {
+		fprintf(stderr, "no mem\n");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+int wl_init(struct landscape *landscape)
+{
+	wl.display = wl_display_connect(NULL);
+	if (!wl.display) {
+		fprintf(stderr, "couldn't connect to display\n");
+		return -1;
+	}
+
+	struct wl_registry *registry = wl_display_get_registry(wl.display);
+	if (!registry) {
+		fprintf(stderr, "couldn't get registry\n");
+		return -1;
+	}
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+
+	wl_display_roundtrip(wl.display);
+	if (check_registry())
+		return -1;
+
+	xdg_wm_base_add_listener(wl.wm, &wm_base_listener, NULL);
+	wl_seat_add_listener(wl.seat, &wl_seat_listener, landscape);
+	wl_display_roundtrip(wl.display);
+	wl.surf = wl_compositor_create_surface(wl.compositor);
+	wl.xdg_surf = xdg_wm_base_get_xdg_surface(wl.wm, wl.surf);
+	xdg_surface_add_listener(wl.xdg_surf, &xdg_surf_listener, landscape);
+	wl.xdg_top = xdg_surface_get_toplevel(wl.xdg_surf);
+	xdg_toplevel_add_listener(wl.xdg_top, &xdg_top_listener, landscape);
+	xdg_toplevel_set_title(wl.xdg_top, "cellularlandscapes");
+	wl_surface_commit(wl.surf);
+
+
+	wl.running = 1;
+	wl.paused = 1;
+	wl.wait_for_config = 1;
+	wl.redraw = 0;
+	wl.pointer_held = 0;
+	wl.pointer_cell = -1;
+	wl.leap = 10;
+	wl.brush = brush_default;
+	wl.repeat_rate = 25;
+	wl.repeat_delay = 600;
+	wl.repeat = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (wl.repeat < 0) {
+		fprintf(stderr, "couldn't make the key repeat timer\n");
+		return -1;
+	}
+
+	view_init(landscape, &wl.view);
+	wl.want_w = wl.view.pw;
+	wl.want_h = wl.view.ph;
+	wl.look_w = wl.view.vw;
+	wl.look = malloc(wl.look_w);
+	if (!wl.look) {
+		fprintf(stderr, "no mem\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static uint64_t splitmix64(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+// Fill the landscape with an even soup, reproducible from seed.
+void landscape_soup(struct landscape *l, uint64_t seed)
+{
+	uint64_t state = seed, bits = 0;
+
+	if (landscape_engine(l)->unpack == packed_unpack) {
+		// straight into the packed rows, which may be far too big to
+		// go through show; the cells come out the same
+		size_t tail = l->width % 64;
+		for (size_t y = 0; y < l->height; y++) {
+			uint64_t *row = &l->packed[y * l->words];
+			for (size_t i = 0; i < l->words; i++)
+				row[i] = splitmix64(&state);
+			if (tail)
+				row[l->words - 1] &= ((uint64_t)1 << tail) - 1;
+		}
+		packed_clear_dying(l);
+		l->show_stale = 1;
+		l->engine_stale = 0;
+		return;
+	}
+
+	landscape_sync(l);
+	for (size_t y = 0; y < l->height; y++) {
+		uint8_t *row = landscape_row(l, l->show, y);
+		for (size_t x = 0; x < l->width; x++) {
+			if ((x & 63) == 0)
+				bits = splitmix64(&state);
+			row[x] = bits >> (x & 63) & 1;
+		}
+	}
+	landscape_touch(l);
+}
+
+// The current generation as a binary PBM, live cells black.
+int landscape_write_pbm(struct landscape *l, const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return -errno;
+
+	// packed rows are written as they are, bar the bit order
+	int packed = landscape_engine(l)->unpack == packed_unpack
+		&& !l->engine_stale;
+
+	if (!packed)
+		landscape_sync(l);
+	fprintf(f, "P4\n%zu %zu\n", l->width, l->height);
+
+	size_t n = (l->width + 7) / 8;
+	uint8_t *line = malloc(n);
+	if (!line) {
+		fclose(f);
+		return -ENOMEM;
+	}
+	for (size_t y = 0; y < l->height; y++) {
+		memset(line, 0, n);
+		if (packed) {
+			const uint64_t *row = &l->packed[y * l->words];
+			for (size_t i = 0; i < n; i++) {
+				uint8_t b = row[i / 8] >> 8 * (i % 8);
+				// PBM wants the leftmost cell in the top bit
+				b = (b & 0xf0) >> 4 | (b & 0x0f) << 4;
+				b = (b & 0xcc) >> 2 | (b & 0x33) << 2;
+				line[i] = (b & 0xaa) >> 1 | (b & 0x55) << 1;
+			}
+		} else {
+			uint8_t *row = landscape_row(l, l->show, y);
+			for (size_t x = 0; x < l->width; x++)
+				line[x / 8] |= (row[x] == 1) << (7 - x % 8);
+		}
+		fwrite(line, 1, n, f);
+	}
+	free(line);
+
+	return fclose(f) ? -errno : 0;
+}
+
+// The rule as a pattern file would name it: `Bx/Sy`, `Bx/Sy/Cn`, Larger
+// than Life's `Rr,Cc,...`, or `Wn` for 1D.
+char *format_rule(struct landscape *l, char *buf, size_t n)
+{
+	if (l->automata == oned)
+		snprintf(buf, n, "W%u", l->rule & 0xff);
+	else if (l->automata == twod_larger)
+		format_ltl_rule(&l->ltl, buf, n);
+	else
+		format_lifelike_rule(l->rule, buf);
+	return buf;
+}
+
+// The other way. Golly's `Bx/Sy`, the older `S/B` digits, either with a
+// number of states for Generations (`Bx/Sy/Cn`, `S/B/n`), Larger than Life
+// and Wolfram's `Wn` are understood; anything after a `:` (the topology) is
+// ignored.
+int parse_rule(struct landscape *l, const char *s)
+{
+	uint32_t rule = 0;
+	const char *p;
+	int n;
+
+	if (*s == 'W' || *s == 'w') {
+		char *end;
+		unsigned long w = strtoul(s + 1, &end, 10);
+		if (end == s + 1 || w > 255 || (*end && *end != ':'))
+			return -1;
+		// the quotient is -q's, or the default's
+		l->rule = w;
+		l->automata = oned;
+		return 0;
+	}
+
+	if (*s == 'R') {
+		struct ltl ltl;
+		if ((n = parse_ltl_rule(s, &ltl)) < 0
+				|| (s[n] && s[n] != ':'))
+			return -1;
+		l->ltl = ltl;
+		l->automata = twod_larger;
+		return 0;
+	}
+
+	if ((n = parse_lifelike_rule(s, &rule)) < 0) {
+		// survival digits, a slash, birth digits
+		for (p = s; *p >= '0' && *p <= '8'; p++)
+			rule |= survive_bit(*p - '0');
+		if (*p++ != '/')
+			return -1;
+		for (; *p >= '0' && *p <= '8'; p++)
+			rule |= birth_bit(*p - '0');
+		if (*p == '/') {
+			char *end;
+			unsigned long c = strtoul(p + 1, &end, 10);
+			if (end == p + 1 || c < 2 || c > STATES_MAX)
+				return -1;
+			rule |= states_bits(c);
+			p = end;
+		}
+		n = p - s;
+	}
+	if (s[n] && s[n] != ':')
+		return -1;
+
+	l->rule = rule;
+	l->automata = twod_life_like;
+	return 0;
+}
+
+// Set n live cells from x on row y of a pattern placed at (x0, y0), clipped
+// to the landscape. `packed` says the packed rows are the truth.
+static void pattern_run(struct landscape *l, int packed, long x0, long y0,
+		long x, long y, long n, uint8_t state)
+{
+	x += x0, y += y0;
+	if (y < 0 || y >= (long)l->height)
+		return;
+	if (x < 0)
+		n += x, x = 0;
+	if (x + n > (long)l->width)
+		n = l->width - x;
+	if (n <= 0)
+		return;
+
+	if (!packed) {
+		memset(landscape_at(l, l->show, x, y), state, n);
+		return;
+	}
+
+	uint64_t *row = &l->packed[y * l->words];
+	for (long end = x + n; x < end; ) {
+		long b = x % 64, k = 64 - b < end - x ? 64 - b : end - x;
+		row[x / 64] |= (k == 64 ? ~(uint64_t)0 : ((uint64_t)1 << k) - 1) << b;
+		x += k;
+	}
+}
+
+static const char *line_end(const char *p, const char *end)
+{
+	const char *q = memchr(p, '\n', end - p);
+	return q ? q : end;
+}
+
+// The RLE header: `x = 3, y = 3, rule = B3/S23`.
+static int rle_header(struct landscape *l, const char *p, const char *eol,
+		long *w, long *h)
+{
+	while (p < eol) {
+		char key[8], value[64];
+		size_t k = 0, v = 0;
+
+		while (p < eol && (*p == ' ' || *p == ',' || *p == '\t' || *p == '\r'))
+			p++;
+		while (p < eol && *p != ' ' && *p != '=' && k < sizeof(key) - 1)
+			key[k++] = *p++;
+		while (p < eol && (*p == ' ' || *p == '='))
+			p++;
+		// Larger than Life's rules have commas of their own
+		key[k] = 0;
+		while (p < eol && *p != ' ' && *p != '\r'
+				&& (*p != ',' || strcmp(key, "rule") == 0)
+				&& v < sizeof(value) - 1)
+			value[v++] = *p++;
+		value[v] = 0;
+
+		if (strcmp(key, "x") == 0)
+			*w = strtol(value, NULL, 10);
+		else if (strcmp(key, "y") == 0)
+			*h = strtol(value, NULL, 10);
+		else if (strcmp(key, "rule") == 0 && parse_rule(l, value) < 0) {
+			fprintf(stderr, "unsupported rule: %s\n", value);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// The body is runs of `<count><tag>`: b (or .) dead, any other letter alive,
+// $ the end of a row and ! the end of the pattern. Under a Generations rule
+// the capitals A..O are states as Golly writes them: A alive, B the first of
+// the dying and so on; b and o keep their meaning.
+static void rle_body(struct landscape *l, int packed, long x0, long y0,
+		const char *p, const char *end)
+{
+	long x = 0, y = 0, n = 0;
+	uint32_t states = l->automata == twod_larger ? l->ltl.states
+		: rule_states(l->rule);
+
+	for (; p < end; p++) {
+		char c = *p;
+
+		if (c >= '0' && c <= '9') {
+			n = n * 10 + c - '0';
+			continue;
+		}
+		if (c == '\n' || c == '\r' || c == ' ' || c == '\t')
+			continue;
+		if (c == '#') {
+			p = line_end(p, end);
+			continue;
+		}
+
+		long run = n ? n : 1;
+		n = 0;
+		if (c == '!')
+			return;
+		else if (c == '$')
+			y += run, x = 0;
+		else if (c == '.' || c == 'b')
+			x += run;
+		else {
+			uint8_t state = states > 2 && c >= 'A'
+				&& c < 'A' + STATES_MAX - 1 ? c - 'A' + 1 : 1;
+			pattern_run(l, packed, x0, y0, x, y, run, state);
+			x += run;
+		}
+	}
+}
+
+// Plaintext: a row per line, O (or *) alive, anything else dead.
+static void cells_body(struct landscape *l, int packed, long x0, long y0,
+		const char *p, const char *end)
+{
+	for (long y = 0; p < end; y++) {
+		const char *eol = line_end(p, end);
+
+		if (*p == '!') {
+			y--;
+		} else {
+			for (const char *q = p; q < eol; ) {
+				if (*q != 'O' && *q != '*') {
+					q++;
+					continue;
+				}
+				const char *r = q;
+				while (r < eol && (*r == 'O' || *r == '*'))
+					r++;
+				pattern_run(l, packed, x0, y0, q - p, y, r - q, 1);
+				q = r;
+			}
+		}
+		p = eol + 1;
+	}
+}
+
+// Replace the landscape with the pattern in an RLE or plaintext (.cells)
+// file, centred. The file is mapped and parsed where it lies, so a pattern
+// of hundreds of megabytes costs one pass over it; the header's rule, if
+// any, becomes the landscape's.
+int landscape_load(struct landscape *l, const char *path)
+{
+	struct stat st;
+	int ret = 0, fd = open(path, O_RDONLY);
+
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		ret = -errno;
+		goto out;
+	}
+
+	const char *m = NULL;
+	if (st.st_size) {
+		m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (m == MAP_FAILED) {
+			ret = -errno;
+			goto out;
+		}
+		madvise((void *)m, st.st_size, MADV_SEQUENTIAL);
+	}
+
+	const char *p = m, *end = m + st.st_size;
+	while (p < end && (*p == '#' || *p == '!' || *p == '\n' || *p == '\r'))
+		p = line_end(p, end) + 1;
+
+	int rle = p < end && *p == 'x';
+	long w = 0, h = 0;
+	if (rle) {
+		const char *eol = line_end(p, end);
+		if (rle_header(l, p, eol, &w, &h) < 0) {
+			ret = -EINVAL;
+			goto unmap;
+		}
+		p = eol + 1 < end ? eol + 1 : end;
+	} else {
+		// a pass for the size, so the pattern can be centred
+		for (const char *q = p; q < end; q = line_end(q, end) + 1) {
+			const char *eol = line_end(q, end);
+			if (*q == '!')
+				continue;
+			if (eol > q && eol[-1] == '\r')
+				eol--;
+			if (eol - q > w)
+				w = eol - q;
+			h++;
+		}
+	}
+
+	if (w > (long)l->width || h > (long)l->height)
+		fprintf(stderr, "%s is %ldx%ld, clipped to %zux%zu\n",
+				path, w, h, l->width, l->height);
+	long x0 = ((long)l->width - w) / 2, y0 = ((long)l->height - h) / 2;
+
+	// the rule may have changed which engine holds the truth; a
+	// Generations rule's states go in through show
+	int packed = landscape_engine(l)->unpack == packed_unpack
+		&& l->states <= 2 && landscape_states(l) == 2;
+	if (packed)
+		memset(l->packed, 0, l->words * l->height * sizeof(uint64_t));
+	else
+		memset(l->show, 0, l->stride * (l->height + 2));
+
+	if (rle)
+		rle_body(l, packed, x0, y0, p, end);
+	else
+		cells_body(l, packed, x0, y0, p, end);
+
+	if (packed) {
+		l->show_stale = 1;
+		l->engine_stale = 0;
+	} else {
+		l->show_stale = 0;
+		landscape_touch(l);
+	}
+
+unmap:
+	if (m)
+		munmap((void *)m, st.st_size);
+out:
+	if (fd >= 0)
+		close(fd);
+	if (ret < 0 && ret != -EINVAL)
+		fprintf(stderr, "couldn't read %s: %s\n", path, strerror(-ret));
+	return ret;
+}
 
-	if (key == KEY_P && state) {
-		// getrandom(ls->cur, ls->width * ls->height, GRND_RANDOM);
-		ls->show[wl.pointer_cell] = !ls->show[wl.pointer_cell];
-	}
+// Row y as a byte per cell, from whichever copy is the truth.
+static const uint8_t *landscape_cells(struct landscape *l, int packed,
+		size_t y, uint8_t *line)
+{
+	if (!packed)
+		return landscape_row(l, l->show, y);
+
+	const uint64_t *row = &l->packed[y * l->words];
+	for (size_t x = 0; x < l->width; x++)
+		line[x] = l->states > 2 ? packed_state(l, x, y)
+			: row[x / 64] >> (x % 64) & 1;
+	return line;
+}
 
-	if (key == KEY_G && state) {
-		if (wl.brush == brush_default)
-			wl.brush = brush_conway_glider;
-		else
-			wl.brush = brush_default;
-	}
+// Append `<n><tag>` to an RLE body, wrapping lines at 70 columns as Golly
+// does.
+static void rle_put(FILE *f, size_t *col, size_t n, char tag)
+{
+	char buf[24];
+	int len = n > 1 ? snprintf(buf, sizeof(buf), "%zu%c", n, tag)
+		: snprintf(buf, sizeof(buf), "%c", tag);
 
-	if (key == KEY_J && state) {
-		wl.pointer_cell += ls->width;
-		wl.pointer_cell %= ls->width * ls->height;
+	if (*col + len > 70) {
+		fputc('\n', f);
+		*col = 0;
 	}
+	fputs(buf, f);
+	*col += len;
+}
 
-	if (key == KEY_K && state) {
-		wl.pointer_cell -= ls->width - ls->width * ls->height;
-		wl.pointer_cell %= ls->width * ls->height;
+static int landscape_write_rle(struct landscape *l, FILE *f, int packed,
+		uint8_t *line)
+{
+	char rule[48];
+	size_t col = 0, rows = 0;
+	// Golly's letters for a Generations rule; otherwise the dying of a
+	// painted one go as dead
+	int letters = l->automata == twod_larger ? l->ltl.states > 2
+		: l->automata == twod_life_like && rule_states(l->rule) > 2;
+	uint8_t mask = letters ? 0xff : 1;
+
+	fprintf(f, "x = %zu, y = %zu, rule = %s\n", l->width, l->height,
+			format_rule(l, rule, sizeof(rule)));
+
+	for (size_t y = 0; y < l->height; y++) {
+		const uint8_t *row = landscape_cells(l, packed, y, line);
+
+		// empty rows are folded into the next row's $
+		for (size_t x = 0; x < l->width; ) {
+			size_t r = x;
+			uint8_t v = row[x] <= mask ? row[x] : 0;
+			while (r < l->width && (row[r] <= mask ? row[r] : 0) == v)
+				r++;
+			if (!v && r == l->width)
+				break;
+			if (rows) {
+				rle_put(f, &col, rows, '$');
+				rows = 0;
+			}
+			rle_put(f, &col, r - x, letters ? (v ? 'A' + v - 1 : '.')
+					: v ? 'o' : 'b');
+			x = r;
+		}
+		rows++;
 	}
+	rle_put(f, &col, 1, '!');
+	fputc('\n', f);
+	return 0;
+}
 
-	if (key == KEY_H && state) {
-		wl.pointer_cell--;
+// Whole rows, dead cells and all, so the size survives a round trip. There's
+// no letter for a Generations rule's dying, so they go as dead.
+static int landscape_write_cells(struct landscape *l, FILE *f, int packed,
+		uint8_t *line)
+{
+	char rule[48];
+
+	fprintf(f, "!Rule: %s\n", format_rule(l, rule, sizeof(rule)));
+	for (size_t y = 0; y < l->height; y++) {
+		const uint8_t *row = landscape_cells(l, packed, y, line);
+		for (size_t x = 0; x < l->width; x++)
+			fputc(row[x] == 1 ? 'O' : '.', f);
+		fputc('\n', f);
 	}
+	return 0;
+}
 
+static int has_suffix(const char *s, const char *suffix)
+{
+	size_t n = strlen(s), k = strlen(suffix);
+	return n >= k && strcmp(s + n - k, suffix) == 0;
+}
 
-	if (key == KEY_L && state) {
-		wl.pointer_cell++;
+// Write the current generation, in a format picked by the file's suffix:
+// .rle, .cells, or a PBM otherwise.
+int landscape_write(struct landscape *l, const char *path)
+{
+	int rle = has_suffix(path, ".rle");
+
+	if (!rle && !has_suffix(path, ".cells"))
+		return landscape_write_pbm(l, path);
+
+	int packed = landscape_engine(l)->unpack == packed_unpack
+		&& !l->engine_stale;
+	if (!packed)
+		landscape_sync(l);
+
+	FILE *f = fopen(path, "w");
+	if (!f)
+		return -errno;
+	uint8_t *line = malloc(l->width);
+	if (!line) {
+		fclose(f);
+		return -ENOMEM;
 	}
 
-	if (key == KEY_SPACE && state)
-		wl.paused = !wl.paused;
+	if (rle)
+		landscape_write_rle(l, f, packed, line);
+	else
+		landscape_write_cells(l, f, packed, line);
+	free(line);
 
-	if (key == KEY_D && state)
-		landscape_debug(ls, wl.pointer_cell);
+	return fclose(f) ? -errno : 0;
+}
 
-	// TODO: step
-	if (key == KEY_N && state) {
-		if (!wl.paused)
-			return
-		landscape_step(ls);
-	}
+// Hardware cache counters for batch runs, if the kernel will hand them out
+// (see perf_event_paranoid). They inherit into threads started after they
+// are opened, so open them before the pool.
+struct {
+	int refs, misses;
+} counters = { -1, -1 };
 
-	if (key == KEY_ESC && state)
-		wl.running = 0;
+static int counter_open(uint64_t config)
+{
+	struct perf_event_attr attr = {
+		.type = PERF_TYPE_HARDWARE,
+		.size = sizeof(attr),
+		.config = config,
+		.disabled = 1,
+		.inherit = 1,
+		.exclude_kernel = 1,
+		.exclude_hv = 1,
+	};
 
-	if (key == KEY_C && state)
-		ls->rule = conway;
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
 
-	if (key == KEY_2 && state)
-		ls->automata = twod_life_like;
+void counters_open(void)
+{
+	counters.refs = counter_open(PERF_COUNT_HW_CACHE_REFERENCES);
+	counters.misses = counter_open(PERF_COUNT_HW_CACHE_MISSES);
+}
 
-	if (key == KEY_1 && state) {
-		wl.paused = 1;
-		ls->rule = 110;
-		ls->automata = oned;
-		ls->quotient = clamped;
+void counters_enable(int on)
+{
+	int fds[] = { counters.refs, counters.misses };
+
+	for (int i = 0; i < 2; i++) {
+		if (fds[i] < 0)
+			continue;
+		if (on)
+			ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(fds[i], on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
 	}
+}
 
-	if (key == KEY_EQUAL && state) {
-		ls->rule++;
-		if (ls->automata == twod_life_like)
-			print_lifelike_rule(ls->rule);
-		else
-			fprintf(stderr, "wolfram number: %d\n", ls->rule & 0xff);
+// The count per cell update, or "-" if there's no counter.
+static char *counter_per(int fd, double cells, char *buf, size_t n)
+{
+	uint64_t v;
 
-	}
-	if (key == KEY_MINUS && state) {
-		ls->rule--;
-		if (ls->automata == twod_life_like)
-			print_lifelike_rule(ls->rule);
-		else
-			fprintf(stderr, "wolfram number: %d\n", ls->rule & 0xff);
-	}
+	if (fd < 0 || read(fd, &v, sizeof(v)) != sizeof(v))
+		snprintf(buf, n, "-");
+	else
+		snprintf(buf, n, "%.4f", v / cells);
+	return buf;
 }
 
-static void keyboard_handle_repeat(void *data, struct wl_keyboard *k,
-		int32_t rate, int32_t delay)
+// Step as fast as the engine goes, with no compositor in the loop.
+int landscape_batch(struct landscape *l)
 {
-	// TODO: who wants to press +/- 256 times to see all the new kinds of
-	// science!!
-}
+	struct timespec t0, t1;
+	char rule[48], refs[32], misses[32], noise[128] = "";
 
-static const struct wl_keyboard_listener keyboard_listener = {
-	.keymap = keyboard_handle_keymap,
-	.enter = keyboard_handle_enter,
-	.leave = keyboard_handle_leave,
-	.key = keyboard_handle_key,
-	.modifiers = keyboard_handle_modifiers,
-	.repeat_info = keyboard_handle_repeat,
-};
+	// rather no run than one that never touched the map
+	if (landscape_engine(l)->advance == mapped_advance && !mapped_holds(l)) {
+		fprintf(stderr, "%s can't hold rule %s\n", l->store,
+				format_rule(l, rule, sizeof(rule)));
+		return -1;
+	}
 
-void seat_handle_caps(void *data, struct wl_seat *seat, uint32_t caps)
-{
-	if ((caps & WL_SEAT_CAPABILITY_POINTER) && !wl.pointer) {
-		wl.pointer = wl_seat_get_pointer(wl.seat);
-		wl_pointer_add_listener(wl.pointer, &wl_pointer_listener, data);
-	} else if ((caps & WL_SEAT_CAPABILITY_POINTER) && wl.pointer) {
-		wl_pointer_destroy(wl.pointer);
-		wl.pointer = NULL;
+	counters_enable(1);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	uint64_t t = prof_now();
+	landscape_advance(l, l->generations);
+	prof_span(prof_step, t);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	counters_enable(0);
+
+	double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1E9;
+	double cells = (double)l->width * l->height * l->generations;
+	if (l->automata == oned)
+		cells = (double)l->width * l->generations;
+
+	format_rule(l, rule, sizeof(rule));
+	if (landscape_noisy(l)) {
+		int n = snprintf(noise, sizeof(noise), " alpha=%.4f",
+				l->alpha / 256.0);
+		for (int p = 7; l->odds_on && p >= 0; p--)
+			n += snprintf(noise + n, sizeof(noise) - n, "%s%.4f",
+					p == 7 ? " odds=" : ",", l->odds[p] / 256.0);
+		snprintf(noise + n, sizeof(noise) - n, " key=%llu",
+				(unsigned long long)l->key);
 	}
 
-	if ((caps & WL_SEAT_CAPABILITY_KEYBOARD) && !wl.keyboard) {
-		wl.keyboard = wl_seat_get_keyboard(seat);
-		wl_keyboard_add_listener(wl.keyboard, &keyboard_listener, data);
-	} else if (!(caps & WL_SEAT_CAPABILITY_KEYBOARD) && wl.keyboard) {
-		wl_keyboard_destroy(wl.keyboard);
-		wl.keyboard = NULL;
+	fprintf(stdout, "engine=%s kernel=%s threads=%zu width=%zu height=%zu "
+			"rule=%s quotient=%s gens=%zu secs=%.6f gens/s=%.1f "
+			"cells/s=%.4g ns/cell=%.4f "
+			"cache-refs/cell=%s cache-misses/cell=%s%s\n",
+			landscape_engine(l)->name, life_row_name(), pool.nthreads,
+			l->width, l->height, rule,
+			landscape_engine(l)->advance == plane_advance ? "plane"
+			: landscape_engine(l)->advance == hashlife_advance ? "none"
+			: l->quotient == quotient_torus ? "torus" : "clamped",
+			l->generations, secs, l->generations / secs,
+			cells / secs, secs * 1E9 / cells,
+			counter_per(counters.refs, cells, refs, sizeof(refs)),
+			counter_per(counters.misses, cells, misses, sizeof(misses)),
+			noise);
+
+	int ret = l->output ? landscape_write(l, l->output) : 0, tr;
+	if (ret < 0)
+		fprintf(stderr, "couldn't write %s: %s\n", l->output, strerror(-ret));
+	if (prof.trace && (tr = prof_write_trace(prof.trace)) < 0) {
+		fprintf(stderr, "couldn't write %s: %s\n", prof.trace, strerror(-tr));
+		ret = ret < 0 ? ret : tr;
 	}
+
+	return ret;
 }
 
-static const struct wl_seat_listener wl_seat_listener = {
-	.capabilities = seat_handle_caps,
-	.name = seat_name,
+// Sweeps run one soup under a list of life-like rules, 64 at a time. In a
+// batch each cell is a word whose bit r is its state under rule r, so the
+// packed engine's adders count the neighbours under all 64 rules at once, and
+// packed_rule_apply steps them all given born and keep masks with bit r set
+// where rule r is born or survives. Batches are shared out between the pool's
+// threads a chunk at a time, and each chunk's results written as it ends.
+//
+// Each rule gets the density it ends on; its activity, the cells changing per
+// cell and generation over the last SWEEP_WINDOW generations; and its period,
+// the least p in that window after which the landscape repeats, 0 for none.
+// Repeats are found by fingerprint: the parity of the cells in each of 64
+// groups, for SWEEP_PARTS ways of grouping them, bit-sliced like the rest.
+#define SWEEP_WINDOW 64
+#define SWEEP_PARTS 4
+#define SWEEP_CHUNK 16 // batches per thread between writes
+#define SWEEP_GENS 1000 // without -n
+
+struct sweep_result {
+	uint32_t rule, period;
+	double density, activity;
 };
 
-void render(void *data) {
-	struct landscape *landscape = data;
-	struct buffer *buf = landscape_next_buffer(landscape);
-	if (!buf)
-		return;
-
-	landscape_draw(landscape, buf);
-	wl_surface_attach(wl.surf, buf->wl_buffer, 0, 0);
-	wl_surface_damage_buffer(wl.surf, 0, 0, INT32_MAX, INT32_MAX);
-	wl.frame_cb = wl_surface_frame(wl.surf);
-	wl_callback_add_listener(wl.frame_cb, &frame_listener, landscape);
+// Words [1, w] of a batch's row from the rows above (a), at (c) and below
+// (e). The block sum is added up as in packed_rule_apply, but with every
+// count live in some lane, the masks are picked by a mux tree on its bits
+// rather than tested a count at a time.
+typedef void (*sweep_row_fn)(uint64_t *out, const uint64_t *a,
+		const uint64_t *c, const uint64_t *e, size_t w,
+		const struct packed_rule *pr);
 
-	wl_surface_commit(wl.surf);
+#define MUX(s, a, b) (((s) & (a)) | (~(s) & (b)))
 
-	wl.redraw = 0;
-	buf->busy = 1;
+static void sweep_row_scalar(uint64_t *out, const uint64_t *a,
+		const uint64_t *c, const uint64_t *e, size_t w,
+		const struct packed_rule *pr)
+{
+	for (size_t i = 1; i <= w; i++) {
+		uint64_t a0, a1, b0, b1, c0, c1, m[10];
+		packed_add3(a[i - 1], a[i], a[i + 1], &a0, &a1);
+		packed_add3(c[i - 1], c[i], c[i + 1], &b0, &b1);
+		packed_add3(e[i - 1], e[i], e[i + 1], &c0, &c1);
+
+		uint64_t t0 = a0 ^ b0 ^ c0, k = (a0 & b0) | (c0 & (a0 ^ b0));
+		uint64_t x0 = a1 ^ b1 ^ c1, x1 = (a1 & b1) | (c1 & (a1 ^ b1));
+		uint64_t t1 = x0 ^ k, y1 = x0 & k, t2 = x1 ^ y1, t3 = x1 & y1;
+
+		for (int n = 0; n < 10; n++)
+			m[n] = MUX(c[i], pr->keep[n], pr->born[n]);
+		uint64_t p01 = MUX(t0, m[1], m[0]), p23 = MUX(t0, m[3], m[2]);
+		uint64_t p45 = MUX(t0, m[5], m[4]), p67 = MUX(t0, m[7], m[6]);
+		uint64_t p89 = MUX(t0, m[9], m[8]);
+		uint64_t q03 = MUX(t1, p23, p01), q47 = MUX(t1, p67, p45);
+		// sums of 8 and 9 have t1 and t2 clear
+		out[i] = MUX(t3, p89, MUX(t2, q47, q03));
+	}
 }
+#undef MUX
+
+#if defined(__x86_64__) || defined(__i386__)
+// Four words to a vector, the same sums and tree.
+__attribute__((target("avx2")))
+static void sweep_row_avx2(uint64_t *out, const uint64_t *a,
+		const uint64_t *c, const uint64_t *e, size_t w,
+		const struct packed_rule *pr)
+{
+#define L(p) _mm256_loadu_si256((const __m256i *)(p))
+#define AND _mm256_and_si256
+#define OR _mm256_or_si256
+#define XOR _mm256_xor_si256
+#define MUX(s, a, b) OR(AND(s, a), _mm256_andnot_si256(s, b))
+	__m256i born[10], keep[10];
+	size_t i = 1;
+
+	for (int n = 0; n < 10; n++) {
+		born[n] = _mm256_set1_epi64x(pr->born[n]);
+		keep[n] = _mm256_set1_epi64x(pr->keep[n]);
+	}
 
-void frame_listener_done(void *data, struct wl_callback *callback, uint32_t time) {
-	wl_callback_destroy(callback);
-	if (!wl.paused && wl.redraw) {
-		render(data);
+	for (; i + 3 <= w; i += 4) {
+		__m256i s[3][2];
+		const uint64_t *rows[3] = { a, c, e };
+		for (int r = 0; r < 3; r++) {
+			__m256i l = L(rows[r] + i - 1), m = L(rows[r] + i);
+			__m256i h = L(rows[r] + i + 1);
+			s[r][0] = XOR(XOR(l, m), h);
+			s[r][1] = OR(AND(l, m), AND(h, XOR(l, m)));
+		}
+
+		__m256i t0 = XOR(XOR(s[0][0], s[1][0]), s[2][0]);
+		__m256i k = OR(AND(s[0][0], s[1][0]),
+				AND(s[2][0], XOR(s[0][0], s[1][0])));
+		__m256i x0 = XOR(XOR(s[0][1], s[1][1]), s[2][1]);
+		__m256i x1 = OR(AND(s[0][1], s[1][1]),
+				AND(s[2][1], XOR(s[0][1], s[1][1])));
+		__m256i t1 = XOR(x0, k), y1 = AND(x0, k);
+		__m256i t2 = XOR(x1, y1), t3 = AND(x1, y1);
+
+		__m256i alive = L(c + i), m[10];
+		for (int n = 0; n < 10; n++)
+			m[n] = MUX(alive, keep[n], born[n]);
+		__m256i p01 = MUX(t0, m[1], m[0]), p23 = MUX(t0, m[3], m[2]);
+		__m256i p45 = MUX(t0, m[5], m[4]), p67 = MUX(t0, m[7], m[6]);
+		__m256i p89 = MUX(t0, m[9], m[8]);
+		__m256i q03 = MUX(t1, p23, p01), q47 = MUX(t1, p67, p45);
+		_mm256_storeu_si256((__m256i *)(out + i),
+				MUX(t3, p89, MUX(t2, q47, q03)));
 	}
+#undef MUX
+#undef XOR
+#undef OR
+#undef AND
+#undef L
+	_mm256_zeroupper();
+	sweep_row_scalar(out + i - 1, a + i - 1, c + i - 1, e + i - 1,
+			w + 1 - i, pr);
 }
+#endif
 
-
-int check_registry(void)
+struct {
+	uint32_t *rules;
+	size_t nrules;
+	size_t first;  // the chunk's first batch
+	size_t gens, window;
+	uint8_t *soup; // the cells to start from, row-major
+	uint8_t *groups; // cell i is in group groups[k*cells + i] of part k
+	struct sweep_result *results; // the chunk's
+	sweep_row_fn row;
+	atomic_int failed;
+} sweep;
+
+// Fill the halo of a batch's grid, stride width + 2, as the quotient would.
+static void sweep_halo(struct landscape *l, uint64_t *g)
 {
-	int ret = 0;
+	size_t w = l->width, h = l->height, s = w + 2;
+	int torus = l->quotient == quotient_torus;
 
-	if (!wl.compositor)
-		fprintf(stderr, "missing compositor\n"), ret++;
-	if (!wl.shm)
-		fprintf(stderr, "missing shm\n"), ret++;
-	if (!wl.wm)
-		fprintf(stderr, "missing xdg_wm_base\n"), ret++;
-	if (!wl.seat)
-		fprintf(stderr, "missing seat\n"), ret++;
+	for (size_t y = 1; y <= h; y++) {
+		uint64_t *row = g + y * s;
+		row[0] = torus ? row[w] : row[1];
+		row[w + 1] = torus ? row[1] : row[w];
+	}
+	memcpy(g, g + (torus ? h : 1) * s, s * sizeof(*g));
+	memcpy(g + (h + 1) * s, g + (torus ? 1 : h) * s, s * sizeof(*g));
+}
 
-	return ret;
+// Add w to bit-sliced counters: bit r of c[i] is bit i of lane r's count.
+static inline void sweep_add(uint64_t c[64], uint64_t w)
+{
+	for (int i = 0; w; i++) {
+		uint64_t carry = c[i] & w;
+		c[i] ^= w;
+		w = carry;
+	}
 }
 
-void brush_default(struct landscape *landscape, int x, int y)
+static uint64_t sweep_lane(const uint64_t c[64], int r)
 {
-	size_t X, Y;
+	uint64_t v = 0;
 
-	landscape->quotient(landscape, x, y, &X, &Y);
-	landscape_set_front(landscape, X, Y, 1);
+	for (int i = 0; i < 64; i++)
+		v |= (c[i] >> r & 1) << i;
+	return v;
 }
 
-void brush_conway_glider(struct landscape *landscape, int x, int y)
+static void sweep_fingerprint(struct landscape *l, const uint64_t *g,
+		uint64_t f[SWEEP_PARTS][64])
 {
-	size_t X, Y;
+	size_t w = l->width, h = l->height, cells = w * h;
+
+	memset(f, 0, SWEEP_PARTS * 64 * sizeof(uint64_t));
+	for (size_t y = 0; y < h; y++) {
+		const uint64_t *row = g + (y + 1) * (w + 2) + 1;
+		for (size_t x = 0; x < w; x++)
+			for (int k = 0; k < SWEEP_PARTS; k++)
+				f[k][sweep.groups[k * cells + y * w + x]] ^= row[x];
+	}
+}
+
+static void sweep_batch(struct landscape *l, size_t b)
+{
+	size_t w = l->width, h = l->height, s = w + 2, cells = w * h;
+	size_t n = sweep.nrules - 64 * b < 64 ? sweep.nrules - 64 * b : 64;
+	size_t gens = sweep.gens, window = sweep.window;
+	const uint32_t *rules = &sweep.rules[64 * b];
+	struct sweep_result *res = &sweep.results[64 * (b - sweep.first)];
+	struct packed_rule pr = {0};
+	uint64_t pop[64] = {0}, changes[64] = {0}, found = 0;
+	uint64_t *g[2] = {
+		calloc(s * (h + 2), sizeof(uint64_t)),
+		calloc(s * (h + 2), sizeof(uint64_t)),
+	};
+	uint64_t (*fp)[SWEEP_PARTS][64] = calloc(window + 1, sizeof(*fp));
 
-	landscape->quotient(landscape, x, y, &X, &Y);
+	if (!(g[0] && g[1] && fp)) {
+		sweep.failed = 1;
+		goto out;
+	}
 
-	landscape_set_front(landscape, X-1, Y+1, 1);
-	landscape_set_front(landscape, X,   Y-1, 1);
-	landscape_set_front(landscape, X,   Y+1, 1);
-	landscape_set_front(landscape, X+1, Y  , 1);
-	landscape_set_front(landscape, X+1, Y+1, 1);
+	for (size_t r = 0; r < n; r++) {
+		struct packed_rule one;
+		packed_rule_compile(rules[r], &one);
+		for (int k = 0; k < 10; k++) {
+			pr.born[k] |= one.born[k] & (uint64_t)1 << r;
+			pr.keep[k] |= one.keep[k] & (uint64_t)1 << r;
+		}
+	}
+
+	for (size_t y = 0; y < h; y++)
+		for (size_t x = 0; x < w; x++)
+			g[0][(y + 1) * s + x + 1] = -(uint64_t)sweep.soup[y * w + x];
+	if (window == gens)
+		sweep_fingerprint(l, g[0], fp[0]);
+
+	// generation t + 1 from t; the last `window` are watched
+	for (size_t t = 0, cur = 0; t < gens; t++, cur = !cur) {
+		const uint64_t *from = g[cur];
+		uint64_t *to = g[!cur];
+		int watched = t + window >= gens;
+
+		sweep_halo(l, g[cur]);
+		for (size_t y = 1; y <= h; y++) {
+			const uint64_t *a = from + (y - 1) * s, *c = a + s;
+			uint64_t *out = to + y * s;
+			sweep.row(out, a, c, c + s, w, &pr);
+			for (size_t x = 1; watched && x <= w; x++)
+				sweep_add(changes, out[x] ^ c[x]);
+		}
+		// generations gens - window on, the first being what the
+		// last is compared with
+		if (t + 1 + window >= gens)
+			sweep_fingerprint(l, to, fp[t + 1 + window - gens]);
+	}
+
+	// the latest fingerprint against those before it, all lanes at once
+	for (size_t p = 1; p <= window; p++) {
+		uint64_t eq = ~found;
+		for (int k = 0; k < SWEEP_PARTS; k++)
+			for (int j = 0; j < 64; j++)
+				eq &= ~(fp[window][k][j] ^ fp[window - p][k][j]);
+		for (size_t r = 0; r < n; r++)
+			if (eq >> r & 1)
+				res[r].period = p;
+		found |= eq;
+	}
+
+	const uint64_t *last = g[gens & 1];
+	for (size_t y = 1; y <= h; y++)
+		for (size_t x = 1; x <= w; x++)
+			sweep_add(pop, last[y * s + x]);
+
+	for (size_t r = 0; r < n; r++) {
+		res[r].rule = rules[r];
+		if (!(found >> r & 1))
+			res[r].period = 0;
+		res[r].density = (double)sweep_lane(pop, r) / cells;
+		res[r].activity = window
+			? (double)sweep_lane(changes, r) / cells / window : 0;
+	}
+out:
+	free(g[0]);
+	free(g[1]);
+	free(fp);
 }
 
-int landscape_init_memory(struct landscape *landscape)
+static void sweep_stripe(struct landscape *l, size_t gen, size_t b0, size_t b1)
 {
-	size_t area = landscape->width * landscape->height;
+	for (size_t b = b0; b < b1; b++)
+		sweep_batch(l, sweep.first + b);
+}
 
-	landscape->flip = calloc(area, 1);
-	landscape->flop = calloc(area, 1);
-	if (!(landscape->flip && landscape->flop)) {
-		fprintf(stderr, "no mem\n");
-		return -ENOMEM;
+// "all" for the whole of the 2^18 life-like rules, "n:m" for rules n up to
+// m as numbers, or a list of Bx/Sy separated by commas.
+static int sweep_parse(const char *spec)
+{
+	unsigned long a, b;
+	char *end;
+
+	if (strcmp(spec, "all") == 0)
+		a = 0, b = 1 << 18;
+	else if ((a = strtoul(spec, &end, 0), *end == ':')
+			&& (b = strtoul(end + 1, &end, 0), !*end)) {
+		if (a >= b || b > 1 << 18)
+			return -1;
+	} else {
+		for (const char *p = spec; ; p++) {
+			uint32_t rule;
+			int n = parse_lifelike_rule(p, &rule);
+			uint32_t *r = realloc(sweep.rules,
+					(sweep.nrules + 1) * sizeof(*r));
+			// a word holds a bit of each rule's cells, so two states
+			if (n < 0 || !r || rule_states(rule) > 2)
+				return -1;
+			sweep.rules = r;
+			sweep.rules[sweep.nrules++] = rule;
+			p += n;
+			if (*p != ',')
+				return *p ? -1 : 0;
+		}
 	}
-	landscape->show = landscape->flip;
 
+	sweep.nrules = b - a;
+	sweep.rules = malloc(sweep.nrules * sizeof(*sweep.rules));
+	if (!sweep.rules)
+		return -1;
+	for (size_t i = 0; i < sweep.nrules; i++)
+		sweep.rules[i] = a + i;
 	return 0;
 }
 
-int wl_init(struct landscape *landscape)
+// Run the sweep asked for with -x, writing a line of CSV per rule to the
+// output, or stdout. The soup is the one -s would sow, so any rule's line can
+// be checked by running it alone.
+int landscape_sweep(struct landscape *l)
 {
-	wl.display = wl_display_connect(NULL);
-	if (!wl.display) {
-		fprintf(stderr, "couldn't connect to display\n");
-		return -1;
-	}
+	size_t cells = l->width * l->height;
+	size_t chunk = pool.nthreads * SWEEP_CHUNK;
+	uint64_t state = l->seed, bits = 0;
+	struct timespec t0, t1;
+	char rule[48];
+	int ret = 0;
 
-	struct wl_registry *registry = wl_display_get_registry(wl.display);
-	if (!registry) {
-		fprintf(stderr, "couldn't get registry\n");
+	if (sweep_parse(l->sweep) < 0) {
+		fprintf(stderr, "can't sweep %s\n", l->sweep);
 		return -1;
 	}
-	wl_registry_add_listener(registry, &registry_listener, NULL);
-
-	wl_display_roundtrip(wl.display);
-	if (check_registry())
+	sweep.gens = l->generations ? l->generations : SWEEP_GENS;
+	sweep.row = sweep_row_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+	if (life_row == life_row_avx2)
+		sweep.row = sweep_row_avx2;
+#endif
+	sweep.window = sweep.gens < SWEEP_WINDOW ? sweep.gens : SWEEP_WINDOW;
+	sweep.soup = malloc(cells);
+	sweep.groups = malloc(SWEEP_PARTS * cells);
+	sweep.results = calloc(64 * chunk, sizeof(*sweep.results));
+	FILE *f = l->output ? fopen(l->output, "w") : stdout;
+	if (!(sweep.soup && sweep.groups && sweep.results && f)) {
+		fprintf(stderr, "couldn't start the sweep\n");
 		return -1;
+	}
 
-	xdg_wm_base_add_listener(wl.wm, &wm_base_listener, NULL);
-	wl_seat_add_listener(wl.seat, &wl_seat_listener, landscape);
-	wl_display_roundtrip(wl.display);
-	wl.surf = wl_compositor_create_surface(wl.compositor);
-	wl.xdg_surf = xdg_wm_base_get_xdg_surface(wl.wm, wl.surf);
-	xdg_surface_add_listener(wl.xdg_surf, &xdg_surf_listener, landscape);
-	wl.xdg_top = xdg_surface_get_toplevel(wl.xdg_surf);
-	xdg_toplevel_set_title(wl.xdg_top, "cellularlandscapes");
-	wl_surface_commit(wl.surf);
-
-
-	wl.running = 1;
-	wl.paused = 1;
-	wl.wait_for_config = 1;
-	wl.redraw = 0;
-	wl.pointer_held = 0;
-	wl.pointer_cell = -1;
-	wl.brush = brush_default;
-
-	return 0;
+	for (size_t y = 0; y < l->height; y++)
+		for (size_t x = 0; x < l->width; x++) {
+			if ((x & 63) == 0)
+				bits = splitmix64(&state);
+			sweep.soup[y * l->width + x] = bits >> (x & 63) & 1;
+		}
+	state = 0;
+	for (size_t i = 0; i < SWEEP_PARTS * cells; i++)
+		sweep.groups[i] = splitmix64(&state) >> 58;
+
+	fprintf(f, "rule,density,activity,period\n");
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	size_t batches = (sweep.nrules + 63) / 64;
+	for (size_t b = 0; b < batches; b += chunk) {
+		size_t nb = batches - b < chunk ? batches - b : chunk;
+		size_t r1 = 64 * (b + nb) < sweep.nrules ? 64 * (b + nb)
+			: sweep.nrules;
+
+		sweep.first = b;
+		pool_run(l, sweep_stripe, 1, nb);
+		if (sweep.failed) {
+			fprintf(stderr, "out of memory for the sweep\n");
+			ret = -ENOMEM;
+			break;
+		}
+		for (size_t r = 64 * b; r < r1; r++) {
+			const struct sweep_result *res = &sweep.results[r - 64 * b];
+			fprintf(f, "%s,%.6f,%.6f,%u\n",
+					format_lifelike_rule(res->rule, rule),
+					res->density, res->activity, res->period);
+		}
+		fflush(f);
+		fprintf(stderr, "\rswept %zu/%zu rules", r1, sweep.nrules);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1E9;
+	fprintf(stderr, " in %.1fs, %.1f rules/s\n", secs, sweep.nrules / secs);
+	if (f != stdout && fclose(f) && !ret)
+		ret = -errno;
+	free(sweep.soup);
+	free(sweep.groups);
+	free(sweep.results);
+	free(sweep.rules);
+	return ret;
 }
 
 int handle_options(struct landscape *l, int argc, char **argv) {
 	char c;
+	int ret;
 	opterr = 0;
 
-	while ((c = getopt(argc, argv, "1:2:w:h:")) != -1) {
+	wl.pace = pace_rate;
+	wl.rate = STEP_RATE;
+	wl.per_frame = 1;
+
+	while ((c = getopt(argc, argv, "1:2:a:c:e:k:m:n:o:p:q:r:s:S:t:T:v:w:x:h:")) != -1) {
 		switch (c) {
 			case '1':
 				l->automata = oned;
@@ -824,14 +6918,158 @@ int handle_options(struct landscape *l, int argc, char **argv) {
 				l->rule = strtoul(optarg, NULL, 10);
 				break;
 
-			case '2':
-				l->rule = strtoul(optarg, NULL, 10);
+			case '2': {
+				// a rule's name or its bits as a number, either
+				// to the end of the argument
+				int n;
+				char *end;
+				l->automata = twod_life_like;
+				if (*optarg == 'R') {
+					n = parse_ltl_rule(optarg, &l->ltl);
+					l->automata = twod_larger;
+				} else if (*optarg >= '0' && *optarg <= '9') {
+					l->rule = strtoul(optarg, &end, 10)
+						& RULE_COUNTS;
+					n = end - optarg;
+				} else
+					n = parse_lifelike_rule(optarg, &l->rule);
+				if (n < 0 || optarg[n])
+					return -1;
+				break;
+			}
+
+			case 'a': {
+				// the chance a cell steps, or a 1D rule's odds
+				// of a live cell for each pattern, a..h
+				uint32_t chance[8];
+				size_t n = 0;
+				char *end;
+				for (char *s = optarg;; s = end + 1) {
+					double p = strtod(s, &end);
+					if (end == s || !(p >= 0 && p <= 1) || n == 8)
+						return -1;
+					chance[n++] = p * 256 + 0.5;
+					if (*end != ',')
+						break;
+				}
+				if (*end || (n != 1 && n != 8))
+					return -1;
+				if (n == 1)
+					l->alpha = chance[0];
+				for (size_t i = 0; n == 8 && i < 8; i++)
+					l->odds[7 - i] = chance[i];
+				l->odds_on = n == 8;
+				break;
+			}
+
+			case 'c': {
+				// cell size in pixels: WxH, or just W for squares
+				char *end;
+				l->cell_width = l->cell_height = strtoul(optarg, &end, 10);
+				if (*end == 'x')
+					l->cell_height = strtoul(end + 1, NULL, 10);
+				if (!l->cell_width || !l->cell_height)
+					return -1;
+				break;
+			}
+
+			case 'e':
+				l->engine = NULL;
+				for (size_t i = 0; i < sizeof(engines)/sizeof(*engines); i++)
+					if (strcmp(optarg, engines[i].name) == 0)
+						l->engine = &engines[i];
+				if (!l->engine) {
+					fprintf(stderr, "unknown engine: %s\n", optarg);
+					return -1;
+				}
+				break;
+
+			case 'k':
+				if ((ret = life_row_select(optarg)) < 0) {
+					fprintf(stderr, ret == -ENOTSUP
+						? "this CPU can't run kernel: %s\n"
+						: "unknown kernel: %s\n", optarg);
+					return -1;
+				}
+				break;
+
+			case 'm':
+				l->store = optarg;
+				for (size_t i = 0; i < sizeof(engines)/sizeof(*engines); i++)
+					if (strcmp(engines[i].name, "mapped") == 0)
+						l->engine = &engines[i];
+				break;
+
+			case 'n':
+				l->generations = strtoul(optarg, NULL, 10);
+				break;
+
+			case 'o':
+				l->output = optarg;
+				break;
+
+			case 'p':
+				l->pattern = optarg;
+				break;
+
+			case 'r': {
+				const char **r = realloc(l->regions,
+						(l->nregions + 1) * sizeof(*r));
+				if (!r)
+					return -1;
+				l->regions = r;
+				l->regions[l->nregions++] = optarg;
+				break;
+			}
+
+			case 'q':
+				if (strcmp(optarg, "torus") == 0)
+					l->quotient = quotient_torus;
+				else if (strcmp(optarg, "clamped") == 0)
+					l->quotient = clamped;
+				else
+					return -1;
+				break;
+
+			case 's':
+				l->seed = strtoull(optarg, NULL, 0);
 				break;
 
+			case 'S':
+				l->key = strtoull(optarg, NULL, 0);
+				break;
+
+			case 't':
+				l->threads = strtoul(optarg, NULL, 10);
+				break;
+
+			case 'T':
+				prof.trace = optarg;
+				break;
+
+			case 'v': {
+				// the pace: N generations/s, Nf a frame, or max
+				char *end;
+				unsigned long n = strtoul(optarg, &end, 10);
+				if (strcmp(optarg, "max") == 0)
+					wl.pace = pace_free;
+				else if (n && strcmp(end, "f") == 0)
+					wl.pace = pace_frame, wl.per_frame = n;
+				else if (n && !*end)
+					wl.pace = pace_rate, wl.rate = n;
+				else
+					return -1;
+				break;
+			}
+
 			case 'w':
 				l->width = strtoul(optarg, NULL, 10);
 				break;
 
+			case 'x':
+				l->sweep = optarg;
+				break;
+
 			case 'h':
 				l->height = strtoul(optarg, NULL, 10);
 				break;
@@ -855,25 +7093,87 @@ int main(int argc, char *argv[])
 		.rule = conway,
 		.automata = twod_life_like,
 		.quotient = quotient_torus,
+		.engine = &engines[0],
+		.threads = 1,
+		.alpha = 256,
+		.states = 2,
 	};
 
+	life_row_select(NULL);
+	raster_row_select();
 	if (handle_options(&landscape, argc, argv))
 		return EXIT_FAILURE;
 
+	// A run with coins is repeated by passing its key back with -S.
+	if (!landscape.key && getrandom(&landscape.key, sizeof(landscape.key),
+				0) != sizeof(landscape.key))
+		landscape.key = time(NULL);
+	if (landscape_noisy(&landscape) && !landscape.generations)
+		fprintf(stderr, "noise key: %llu\n",
+				(unsigned long long)landscape.key);
+
 	if ((ret = landscape_init_memory(&landscape)) < 0) {
 		fprintf(stderr, fail_landscape_init);
 		return ret;
 	}
 
+	if (landscape.generations)
+		counters_open();
+
+	if ((ret = pool_init(landscape.threads)) < 0) {
+		fprintf(stderr, "couldn't start the stepping threads\n");
+		return ret;
+	}
+
+	if (landscape.sweep) {
+		ret = landscape_sweep(&landscape);
+		pool_fini();
+		return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	if (landscape.pattern) {
+		if (landscape_load(&landscape, landscape.pattern) < 0)
+			return EXIT_FAILURE;
+	} else if (landscape.seed)
+		landscape_soup(&landscape, landscape.seed);
+	else if (landscape.automata == oned) {
+		*landscape_at(&landscape, landscape.show, landscape.width/2, 0) = 1;
+		landscape_touch(&landscape);
+	}
+
+	landscape.ink = landscape.rule;
+	for (size_t i = 0; i < landscape.nregions; i++)
+		if ((ret = landscape_paint_region(&landscape,
+				landscape.regions[i])) < 0) {
+			fprintf(stderr, ret == -ENOTSUP
+				? "couldn't paint %s: Larger than Life has one rule\n"
+				: "couldn't paint %s\n", landscape.regions[i]);
+			return EXIT_FAILURE;
+		}
+
+	if (landscape.generations) {
+		ret = landscape_batch(&landscape);
+		pool_fini();
+		return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
 	if ((ret = wl_init(&landscape)) < 0) {
 		fprintf(stderr, fail_wl_init);
 		return ret;
 	}
 
-	struct timespec now = {0}, then = {0}, timeout = {0, 1E6};
+	if ((ret = sim_start(&landscape)) < 0) {
+		fprintf(stderr, "couldn't start the simulation\n");
+		return ret;
+	}
+
 	fd_set rfds;
+	eventfd_t n;
 
 	int wlfd = wl_display_get_fd(wl.display);
+	int nfds = (wlfd > sim.ready ? wlfd : sim.ready) + 1;
+	if (wl.repeat >= nfds)
+		nfds = wl.repeat + 1;
 
 	while (wl.wait_for_config)
 		ret = wl_display_dispatch(wl.display);
@@ -884,27 +7184,32 @@ int main(int argc, char *argv[])
 	while (wl.running) {
 		FD_ZERO(&rfds);
 		FD_SET(wlfd, &rfds);
-		if (pselect(wlfd+1, &rfds, NULL, NULL, &timeout, NULL) < 0) {
+		FD_SET(sim.ready, &rfds);
+		FD_SET(wl.repeat, &rfds);
+		uint64_t t = prof_now();
+		if (pselect(nfds, &rfds, NULL, NULL, NULL, NULL) < 0) {
 			if (errno == EINTR)
 				continue;
 			return EXIT_FAILURE;
 		}
+		prof_span(prof_wait, t);
 
-                if (FD_ISSET(wlfd, &rfds) && wl_display_dispatch(wl.display) == -1)  {
-			return EXIT_FAILURE;
+		if (FD_ISSET(wlfd, &rfds)) {
+			t = prof_now();
+			if (wl_display_dispatch(wl.display) == -1)
+				return EXIT_FAILURE;
+			prof_span(prof_dispatch, t);
 		}
 
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		long dt_ms = (now.tv_sec - then.tv_sec)*1000
-				+ (now.tv_nsec - then.tv_nsec)/1E6;
-		if (!wl.paused && dt_ms >= STEP_TIME_MSEC) {
-			landscape_step(&landscape);
-			then = now;
-		}
+		// a new generation is waiting
+		if (FD_ISSET(sim.ready, &rfds) && eventfd_read(sim.ready, &n) == 0)
+			wl.redraw = 1;
 
-                if (!wl.frame_cb || wl.redraw) {
+		if (FD_ISSET(wl.repeat, &rfds))
+			keyboard_repeat(&landscape);
+
+		if (!wl.frame_cb && wl.redraw)
 			render(&landscape);
-		}
 
 		if (wl_display_dispatch_pending(wl.display) < 0)
 			return EXIT_FAILURE;
@@ -912,5 +7217,9 @@ int main(int argc, char *argv[])
 			return EXIT_FAILURE;
 	}
 
+	sim_stop();
+	pool_fini();
+	if (prof.trace && (ret = prof_write_trace(prof.trace)) < 0)
+		fprintf(stderr, "couldn't write %s: %s\n", prof.trace, strerror(-ret));
 	return EXIT_SUCCESS;
 }